@@ -65,6 +65,20 @@ android {
         viewBinding = true
     }
     
+    // Store Whisper models uncompressed so the native loader can mmap them
+    // straight out of the APK instead of inflating a second copy
+    androidResources {
+        noCompress += "bin"
+    }
+    
+    // Extract native libraries to nativeLibraryDir so the ggml CPU backend
+    // variants (libggml-cpu-*.so) can be found and loaded by path at runtime
+    packaging {
+        jniLibs {
+            useLegacyPackaging = true
+        }
+    }
+    
     externalNativeBuild {
         cmake {
             path = file("src/main/cpp/CMakeLists.txt")
@@ -0,0 +1,128 @@
+package com.memexos.app.whisper
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import com.memexagent.app.audio.NativeAudioRingBuffer
+import com.memexagent.app.whisper.StreamingSession
+import com.memexagent.app.whisper.WhisperService
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertThrows
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+import java.lang.reflect.InvocationTargetException
+import java.lang.reflect.Modifier
+import java.nio.ByteBuffer
+
+/**
+ * Instrumented tests that load libmemexagent_native.so and call its JNI
+ * exports, including the native ring buffer that the JVM unit tests cannot
+ * create.
+ *
+ * WhisperServiceTest mocks every native, so an export whose name does not
+ * match the Kotlin package only fails on a device, with UnsatisfiedLinkError
+ * on first use. Each WhisperService native is called here with arguments it
+ * rejects or ignores (null handles, missing files), so no model is needed.
+ */
+@RunWith(AndroidJUnit4::class)
+class NativeBindingsTest {
+
+    private val context = InstrumentationRegistry.getInstrumentation().targetContext
+
+    // Arguments for each WhisperService native that are safe without a model
+    private val whisperServiceCalls: Map<String, Array<Any?>> = mapOf(
+        "initContext" to arrayOf("/nonexistent/ggml-tiny.bin"),
+        "initContextFromAsset" to arrayOf(context.assets, "models/nonexistent.bin"),
+        "freeContext" to arrayOf(0L),
+        "fullTranscribe" to arrayOf(0L, 1, 0, FloatArray(16), 0L),
+        "fullTranscribePcm16" to arrayOf(0L, 1, 0, ByteBuffer.allocateDirect(32), 0, 32, 0L),
+        "fullTranscribeRing" to arrayOf(0L, 1, 0, 0L, 16, 0L),
+        "getEncodeStats" to arrayOf(0L),
+        "fullTranscribeLong" to arrayOf(0L, 1, FloatArray(16), 300, 25000, 1, 0L),
+        "nativeCreateCancelToken" to arrayOf(0L),
+        "nativeCancel" to arrayOf(0L),
+        "nativeCancelLatencyMs" to arrayOf(0L),
+        "nativeFreeCancelToken" to arrayOf(0L),
+        "getChunkStats" to arrayOf(0L),
+        "nativeGetStageTimings" to arrayOf(0L),
+        "nativeWriteTrace" to arrayOf(File(context.cacheDir, "native-bindings-trace.json").absolutePath),
+        "freeResult" to arrayOf(0L),
+        "streamOpen" to arrayOf(0L, 1, 500, 5000, 200, false, 0L),
+        "exportResult" to arrayOf(0L, ByteBuffer.allocateDirect(16)),
+        "setDecoderStatePoolSize" to arrayOf(0L, 1),
+        "getMemoryStats" to arrayOf(0L),
+        "setVadEnabled" to arrayOf(0L, false, 300, 100),
+        "nativeSetCommandGrammar" to arrayOf(0L, null, 100f),
+        "nativeSetTranscriptionListener" to arrayOf(0L, null),
+        "nativeSetCascade" to arrayOf(0L, null, null, 0.5f),
+        "getCascadeStats" to arrayOf(0L),
+        "resetCascadeStats" to arrayOf(0L),
+        "detectSpeechSegments" to arrayOf(FloatArray(1600)),
+        "setModelLoadOptions" to arrayOf(true, false),
+        "getCpuTopology" to arrayOf(),
+        "nativeSetCorePinning" to arrayOf(true),
+        "nativeLoadCpuBackend" to arrayOf(context.applicationInfo.nativeLibraryDir),
+        "nativeGetCpuFeatures" to arrayOf(),
+        "nativeMeasureThreadStartup" to arrayOf(0L, 1, 1, FloatArray(16)),
+        "nativeEvictModel" to arrayOf("/nonexistent/ggml-tiny.bin"),
+        "nativeEvictUnusedModels" to arrayOf()
+    )
+
+    @Test
+    fun whisperService_everyNative_links() {
+        val service = WhisperService(context)
+        val natives = WhisperService::class.java.declaredMethods.filter { Modifier.isNative(it.modifiers) }
+
+        // A native added without an entry here would go unchecked
+        assertEquals(natives.map { it.name }.toSortedSet(), whisperServiceCalls.keys.toSortedSet())
+
+        for (method in natives) {
+            method.isAccessible = true
+            try {
+                method.invoke(service, *whisperServiceCalls.getValue(method.name))
+            } catch (e: InvocationTargetException) {
+                throw AssertionError("${method.name} failed", e.targetException)
+            }
+        }
+    }
+
+    @Test
+    fun nativeAudioRingBuffer_roundTrip_links() {
+        NativeAudioRingBuffer(1024).use { ring ->
+            assertEquals(1024, ring.capacity)
+            assertEquals(4, ring.write(shortArrayOf(1, 2, 3, 4)))
+            assertEquals(2, ring.write(ByteBuffer.allocateDirect(4)))
+            assertEquals(6, ring.available())
+
+            val out = ShortArray(4)
+            assertEquals(4, ring.read(out))
+            ring.clear()
+            assertEquals(0, ring.available())
+            assertEquals(0L, ring.overrunSamples())
+            assertEquals(6L, ring.totalWritten())
+        }
+    }
+
+    @Test
+    fun openStream_closedRing_isRejected() {
+        val ring = NativeAudioRingBuffer(1024)
+        ring.close()
+
+        // Without the check the session would silently read its own ring
+        assertThrows(IllegalStateException::class.java) {
+            WhisperService(context).openStream(ring = ring)
+        }
+    }
+
+    @Test
+    fun streamingSession_onRing_refusesPush() {
+        NativeAudioRingBuffer(1024).use { ring ->
+            // Never reaches native code, so no session is needed behind it
+            val session = StreamingSession(0L, 500, ring)
+
+            // The ring's capture thread is its only producer
+            assertThrows(IllegalStateException::class.java) { session.push(ShortArray(160)) }
+            assertEquals(0, ring.available())
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#include "asset_loader.h"
+
+#include <chrono>
+#include <unistd.h>
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+size_t read_asset(void * ctx, void * output, size_t read_size) {
+    AAsset * asset = static_cast<AAsset *>(ctx);
+    uint8_t * dst = static_cast<uint8_t *>(output);
+
+    // AAsset_read may return short counts for compressed assets
+    size_t n_read = 0;
+    while (n_read < read_size) {
+        const int n = AAsset_read(asset, dst + n_read, read_size - n_read);
+        if (n <= 0) {
+            break;
+        }
+        n_read += (size_t) n;
+    }
+    return n_read;
+}
+
+bool eof_asset(void * ctx) {
+    return AAsset_getRemainingLength64(static_cast<AAsset *>(ctx)) <= 0;
+}
+
+void close_asset(void * /* ctx */) {
+    // The asset is closed by load_model_from_asset.
+}
+
+struct whisper_context * load_mapped_asset(int fd, off64_t start, off64_t length,
+                                           const std::string & asset_path,
+                                           const struct whisper_context_params & cparams,
+                                           const LoadOptions & options) {
+    MappedRegion region;
+    if (!region.map(fd, start, (size_t) length, options)) {
+        return nullptr;
+    }
+
+    LOGI("Mapped uncompressed asset %s (offset: %lld, size: %lld bytes)",
+         asset_path.c_str(), (long long) start, (long long) length);
+
+    MappedModelReader reader;
+    reader.region = &region;
+    whisper_model_loader loader = reader.loader();
+    return whisper_init_with_params_no_state(&loader, cparams);
+}
+
+} // namespace
+
+struct whisper_context * load_model_from_asset(AAssetManager * mgr,
+                                               const std::string & asset_path,
+                                               const struct whisper_context_params & cparams,
+                                               const LoadOptions & options) {
+    const size_t rss_before = current_rss_bytes();
+    const auto t_start = std::chrono::steady_clock::now();
+
+    AAsset * asset = AAssetManager_open(mgr, asset_path.c_str(), AASSET_MODE_STREAMING);
+    if (asset == nullptr) {
+        LOGE("Failed to open asset: %s", asset_path.c_str());
+        return nullptr;
+    }
+
+    struct whisper_context * ctx = nullptr;
+    const char * path_kind = "streamed";
+
+    // Only stored (uncompressed) assets have a file descriptor
+    off64_t start = 0;
+    off64_t length = 0;
+    const int fd = options.use_mmap ? AAsset_openFileDescriptor64(asset, &start, &length) : -1;
+    if (fd >= 0) {
+        ctx = load_mapped_asset(fd, start, length, asset_path, cparams, options);
+        close(fd);
+        path_kind = "mapped";
+    }
+
+    if (ctx == nullptr) {
+        if (fd >= 0) {
+            LOGW("Mapped load failed, falling back to streaming: %s", asset_path.c_str());
+            AAsset_close(asset);
+            asset = AAssetManager_open(mgr, asset_path.c_str(), AASSET_MODE_STREAMING);
+            if (asset == nullptr) {
+                LOGE("Failed to reopen asset: %s", asset_path.c_str());
+                return nullptr;
+            }
+        } else {
+            LOGI("Asset %s is compressed, streaming it (store it uncompressed to enable mmap)",
+                 asset_path.c_str());
+        }
+
+        whisper_model_loader loader = {};
+        loader.context = asset;
+        loader.read = read_asset;
+        loader.eof = eof_asset;
+        loader.close = close_asset;
+        ctx = whisper_init_with_params_no_state(&loader, cparams);
+        path_kind = "streamed";
+    }
+
+    AAsset_close(asset);
+
+    if (ctx == nullptr) {
+        return nullptr;
+    }
+
+    const auto t_load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t_start).count();
+    const size_t rss_after = current_rss_bytes();
+
+    LOGI("Asset model load (%s): %lld ms, RSS %.1f MB -> %.1f MB",
+         path_kind, (long long) t_load_ms,
+         rss_before / (1024.0 * 1024.0), rss_after / (1024.0 * 1024.0));
+    return ctx;
+}
+
+} // namespace memex
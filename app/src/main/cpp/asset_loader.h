@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <android/asset_manager.h>
+#include "model_loader.h"
+#include "whisper.h"
+
+namespace memex {
+
+// Load a model packaged in the APK without a default state.
+//
+// Uncompressed (noCompress) assets are mapped straight out of the APK via the
+// asset's file descriptor and offset. Compressed assets are inflated through
+// a streaming loader, so at no point is a full second copy of the model held
+// next to the tensors being filled.
+struct whisper_context * load_model_from_asset(AAssetManager * mgr,
+                                               const std::string & asset_path,
+                                               const struct whisper_context_params & cparams,
+                                               const LoadOptions & options);
+
+} // namespace memex
@@ -0,0 +1,75 @@
+#include "audio_ctx.h"
+
+#include <algorithm>
+
+namespace memex {
+
+int adaptive_audio_ctx(struct whisper_context * ctx, int n_samples, const AudioCtxParams & params) {
+    const int n_audio_ctx = whisper_model_n_audio_ctx(ctx);
+    const int64_t clip_ms = (int64_t) n_samples * 1000 / WHISPER_SAMPLE_RATE;
+    if (clip_ms > params.max_clip_ms) {
+        return 0;
+    }
+
+    const int n_layer = whisper_model_n_audio_layer(ctx);
+    const int min_ctx = n_layer <= 4 ? 384 : n_layer <= 6 ? 256 : 192;
+
+    const int granularity = std::max(1, params.granularity);
+    int audio_ctx = (int) ((clip_ms + params.margin_ms) * kEncoderFramesPerSecond + 999) / 1000;
+    audio_ctx = (audio_ctx + granularity - 1) / granularity * granularity;
+    audio_ctx = std::max(audio_ctx, min_ctx);
+
+    // Nothing to gain once the context is within a step of the full window
+    return audio_ctx + granularity >= n_audio_ctx ? 0 : audio_ctx;
+}
+
+void EncodeTimer::attach(whisper_full_params & wparams) {
+    prev_encoder_begin_      = wparams.encoder_begin_callback;
+    prev_encoder_begin_data_ = wparams.encoder_begin_callback_user_data;
+    prev_logits_filter_      = wparams.logits_filter_callback;
+    prev_logits_filter_data_ = wparams.logits_filter_callback_user_data;
+
+    wparams.encoder_begin_callback           = on_encoder_begin;
+    wparams.encoder_begin_callback_user_data = this;
+    wparams.logits_filter_callback           = on_logits;
+    wparams.logits_filter_callback_user_data = this;
+}
+
+double EncodeTimer::encode_ms() const {
+    return n_windows() > 0 ? encode_ms_ : 0.0;
+}
+
+double EncodeTimer::mel_ms() const {
+    if (n_windows() == 0 || t_start_ == std::chrono::steady_clock::time_point()) {
+        return 0.0;
+    }
+    return std::chrono::duration<double, std::milli>(t_first_begin_ - t_start_).count();
+}
+
+bool EncodeTimer::on_encoder_begin(struct whisper_context * ctx, struct whisper_state * state, void * user_data) {
+    EncodeTimer * timer = static_cast<EncodeTimer *>(user_data);
+    timer->t_begin_ = std::chrono::steady_clock::now();
+    if (timer->t_first_begin_ == std::chrono::steady_clock::time_point()) {
+        timer->t_first_begin_ = timer->t_begin_;
+    }
+    timer->pending_.store(true, std::memory_order_release);
+    return timer->prev_encoder_begin_ == nullptr
+        || timer->prev_encoder_begin_(ctx, state, timer->prev_encoder_begin_data_);
+}
+
+void EncodeTimer::on_logits(struct whisper_context * ctx, struct whisper_state * state,
+                            const whisper_token_data * tokens, int n_tokens, float * logits, void * user_data) {
+    EncodeTimer * timer = static_cast<EncodeTimer *>(user_data);
+    // Decoders may filter logits in parallel; only the first one after each
+    // encoder run stamps
+    if (timer->pending_.exchange(false, std::memory_order_acq_rel)) {
+        timer->encode_ms_ += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - timer->t_begin_).count();
+        timer->n_windows_.fetch_add(1, std::memory_order_release);
+    }
+    if (timer->prev_logits_filter_ != nullptr) {
+        timer->prev_logits_filter_(ctx, state, tokens, n_tokens, logits, timer->prev_logits_filter_data_);
+    }
+}
+
+} // namespace memex
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include "whisper.h"
+
+namespace memex {
+
+// Encoder frames per second of audio: the 30 s window is 1500 frames.
+constexpr int kEncoderFramesPerSecond = 50;
+
+struct AudioCtxParams {
+    int margin_ms   = 1000;   // trailing audio beyond the clip, so the decoder sees the end of speech
+    int granularity = 64;     // round the context up to a multiple of this many frames
+    int max_clip_ms = 15000;  // longer clips use the full window
+};
+
+// Encoder context (audio_ctx) sized to a clip of `n_samples` plus the safety
+// margin, for short voice commands. Returns 0 (full 30 s window) when the clip
+// is too long to benefit.
+//
+// Shrinking the context costs accuracy on the smallest models first, so the
+// result never drops below a floor that depends on encoder depth: 384 frames
+// (7.7 s) for tiny, 256 (5.1 s) for base, 192 (3.8 s) otherwise.
+int adaptive_audio_ctx(struct whisper_context * ctx, int n_samples, const AudioCtxParams & params = AudioCtxParams());
+
+// Times the encoder of a whisper_full call: from each encoder-begin callback
+// to the first logits the decoder produces after it (which also covers the
+// one-step prompt decode, small next to the encoder), summed over the 30 s
+// windows of a long clip. Chains to any callbacks already set in the params.
+class EncodeTimer {
+public:
+    void attach(whisper_full_params & wparams);
+
+    // Stamp the start of whisper_full, right before the call, so the time to
+    // the encoder (the mel spectrogram) can be reported.
+    void start() { t_start_ = std::chrono::steady_clock::now(); }
+
+    // Milliseconds over all windows, or 0 if the encoder never ran. Read
+    // once whisper_full has returned.
+    double encode_ms() const;
+
+    // Windows whose encoder time is included in encode_ms().
+    int n_windows() const { return n_windows_.load(std::memory_order_acquire); }
+
+    // Milliseconds from start() to the first encoder run, or 0 if either is
+    // missing.
+    double mel_ms() const;
+
+private:
+    static bool on_encoder_begin(struct whisper_context * ctx, struct whisper_state * state, void * user_data);
+    static void on_logits(struct whisper_context * ctx, struct whisper_state * state,
+                          const whisper_token_data * tokens, int n_tokens, float * logits, void * user_data);
+
+    std::chrono::steady_clock::time_point t_start_;
+    std::chrono::steady_clock::time_point t_first_begin_;
+    std::chrono::steady_clock::time_point t_begin_;  // current window
+    double encode_ms_ = 0.0;
+    std::atomic<bool> pending_{false};  // a window began and has no logits yet
+    std::atomic<int> n_windows_{0};
+
+    whisper_encoder_begin_callback prev_encoder_begin_ = nullptr;
+    void * prev_encoder_begin_data_ = nullptr;
+    whisper_logits_filter_callback prev_logits_filter_ = nullptr;
+    void * prev_logits_filter_data_ = nullptr;
+};
+
+} // namespace memex
@@ -0,0 +1,76 @@
+#include "cancel.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace memex {
+
+namespace {
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+CancelToken::CancelToken(int64_t timeout_ms)
+    : deadline_ns_(timeout_ms > 0 ? now_ns() + timeout_ms * 1000000 : 0) {}
+
+void CancelToken::cancel() {
+    int64_t expected = 0;
+    cancel_ns_.compare_exchange_strong(expected, now_ns());
+    cancelled_.store(true, std::memory_order_relaxed);
+}
+
+bool CancelToken::expired() const {
+    return deadline_ns_ != 0 && now_ns() >= deadline_ns_;
+}
+
+void CancelToken::attach(whisper_full_params & wparams) {
+    prev_abort_              = wparams.abort_callback;
+    prev_abort_data_         = wparams.abort_callback_user_data;
+    prev_encoder_begin_      = wparams.encoder_begin_callback;
+    prev_encoder_begin_data_ = wparams.encoder_begin_callback_user_data;
+
+    wparams.abort_callback                   = on_abort;
+    wparams.abort_callback_user_data         = this;
+    wparams.encoder_begin_callback           = on_encoder_begin;
+    wparams.encoder_begin_callback_user_data = this;
+}
+
+void CancelToken::on_decode_returned() {
+    const int64_t now = now_ns();
+    int64_t prev = last_return_ns_.load();
+    while (prev < now && !last_return_ns_.compare_exchange_weak(prev, now)) {
+    }
+}
+
+double CancelToken::idle_latency_ms() const {
+    int64_t aborted_ns = cancel_ns_.load();
+    if (aborted_ns == 0 && expired()) {
+        aborted_ns = deadline_ns_;
+    }
+    const int64_t returned_ns = last_return_ns_.load();
+    if (aborted_ns == 0 || returned_ns == 0) {
+        return -1.0;
+    }
+    return std::max<int64_t>(0, returned_ns - aborted_ns) / 1e6;
+}
+
+bool CancelToken::on_abort(void * user_data) {
+    CancelToken * token = static_cast<CancelToken *>(user_data);
+    return token->should_abort()
+        || (token->prev_abort_ != nullptr && token->prev_abort_(token->prev_abort_data_));
+}
+
+bool CancelToken::on_encoder_begin(struct whisper_context * ctx, struct whisper_state * state, void * user_data) {
+    CancelToken * token = static_cast<CancelToken *>(user_data);
+    if (token->should_abort()) {
+        return false;
+    }
+    return token->prev_encoder_begin_ == nullptr
+        || token->prev_encoder_begin_(ctx, state, token->prev_encoder_begin_data_);
+}
+
+} // namespace memex
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "whisper.h"
+
+namespace memex {
+
+// Cancellation flag and optional deadline for one request, shared between the
+// caller and the decode thread(s). Attached to whisper_full_params it stops
+// the decode through both hooks whisper.cpp offers: encoder_begin_callback
+// (before each encoder pass) and abort_callback (between graph nodes and
+// decode steps), so the compute threads wind down within one graph node.
+class CancelToken {
+public:
+    // `timeout_ms` <= 0 means no deadline.
+    explicit CancelToken(int64_t timeout_ms = 0);
+
+    CancelToken(const CancelToken &) = delete;
+    CancelToken & operator=(const CancelToken &) = delete;
+
+    void cancel();
+
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+    bool expired() const;
+    bool should_abort() const { return cancelled() || expired(); }
+
+    // Point the abort and encoder-begin callbacks of `wparams` at this token,
+    // chaining to any callbacks already set. The token must outlive the decode.
+    void attach(whisper_full_params & wparams);
+
+    // Record that a decode using this token has returned.
+    void on_decode_returned();
+
+    // Milliseconds from the cancel request (or the deadline) until the last
+    // decode using the token returned, i.e. until its compute threads were
+    // idle. -1 if the request was never aborted.
+    double idle_latency_ms() const;
+
+private:
+    static bool on_abort(void * user_data);
+    static bool on_encoder_begin(struct whisper_context * ctx, struct whisper_state * state, void * user_data);
+
+    std::atomic<bool> cancelled_{false};
+    std::atomic<int64_t> cancel_ns_{0};
+    std::atomic<int64_t> last_return_ns_{0};
+    int64_t deadline_ns_ = 0;
+
+    ggml_abort_callback prev_abort_ = nullptr;
+    void * prev_abort_data_ = nullptr;
+    whisper_encoder_begin_callback prev_encoder_begin_ = nullptr;
+    void * prev_encoder_begin_data_ = nullptr;
+};
+
+} // namespace memex
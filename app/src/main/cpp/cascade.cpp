@@ -0,0 +1,66 @@
+#include "cascade.h"
+
+#include <algorithm>
+
+namespace memex {
+
+namespace {
+
+double percentile(std::vector<double> sorted, double q) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[(size_t) ((sorted.size() - 1) * q)];
+}
+
+} // namespace
+
+void CascadeStats::record(float confidence, bool escalated, double primary_ms, double fallback_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    ++totals_.n_requests;
+    sum_primary_ms_ += primary_ms;
+    if (escalated) {
+        ++totals_.n_escalated;
+        sum_fallback_ms_ += fallback_ms;
+    }
+
+    const int bucket = std::min(kConfidenceBuckets - 1, std::max(0, (int) (confidence * kConfidenceBuckets)));
+    ++totals_.confidence_histogram[bucket];
+
+    const double total_ms = primary_ms + (escalated ? fallback_ms : 0.0);
+    if (latencies_.size() < kLatencyWindow) {
+        latencies_.push_back(total_ms);
+    } else {
+        latencies_[next_latency_] = total_ms;
+        next_latency_ = (next_latency_ + 1) % kLatencyWindow;
+    }
+}
+
+CascadeStats::Snapshot CascadeStats::snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Snapshot snapshot = totals_;
+    if (totals_.n_requests > 0) {
+        snapshot.mean_primary_ms = sum_primary_ms_ / totals_.n_requests;
+    }
+    if (totals_.n_escalated > 0) {
+        snapshot.mean_fallback_ms = sum_fallback_ms_ / totals_.n_escalated;
+    }
+    snapshot.p50_ms = percentile(latencies_, 0.5);
+    snapshot.p90_ms = percentile(latencies_, 0.9);
+    return snapshot;
+}
+
+void CascadeStats::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    totals_ = Snapshot();
+    sum_primary_ms_ = 0.0;
+    sum_fallback_ms_ = 0.0;
+    latencies_.clear();
+    next_latency_ = 0;
+}
+
+} // namespace memex
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "model_registry.h"
+
+namespace memex {
+
+// A larger resident model to re-decode with when the primary model's
+// transcript confidence (see transcript_confidence) is below `threshold`.
+struct Cascade {
+    std::shared_ptr<Model> model;
+    float threshold = 0.6f;
+};
+
+// Escalation statistics for tuning a cascade threshold. Thread-safe.
+class CascadeStats {
+public:
+    static constexpr int kConfidenceBuckets = 10;  // [0, 0.1), [0.1, 0.2), ... [0.9, 1]
+    static constexpr size_t kLatencyWindow = 256;  // recent requests kept for percentiles
+
+    struct Snapshot {
+        int64_t n_requests = 0;
+        int64_t n_escalated = 0;
+        double mean_primary_ms = 0.0;   // primary decode, all requests
+        double mean_fallback_ms = 0.0;  // re-decode, escalated requests only
+        double p50_ms = 0.0;            // end-to-end, recent requests
+        double p90_ms = 0.0;
+        // Primary-model confidence of every request, so the escalation rate
+        // at another threshold can be read off without re-running
+        std::array<int64_t, kConfidenceBuckets> confidence_histogram{};
+    };
+
+    void record(float confidence, bool escalated, double primary_ms, double fallback_ms);
+    Snapshot snapshot();
+    void reset();
+
+private:
+    std::mutex mutex_;
+    Snapshot totals_;
+    double sum_primary_ms_ = 0.0;
+    double sum_fallback_ms_ = 0.0;
+    std::vector<double> latencies_;
+    size_t next_latency_ = 0;
+};
+
+} // namespace memex
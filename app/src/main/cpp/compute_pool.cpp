@@ -0,0 +1,93 @@
+#include "compute_pool.h"
+
+#include <algorithm>
+#include "log.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace memex {
+
+ComputePool & ComputePool::instance() {
+    static ComputePool pool;
+    return pool;
+}
+
+ComputePool::~ComputePool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread & worker : workers_) {
+        worker.join();
+    }
+}
+
+std::future<void> ComputePool::submit(std::function<void()> task) {
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> done = packaged.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(packaged));
+        if (n_idle_ < (int) tasks_.size() && (int) workers_.size() < kMaxWorkers) {
+            start_worker_locked();
+        }
+    }
+    cv_.notify_one();
+    return done;
+}
+
+void ComputePool::reserve(int n_workers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while ((int) workers_.size() < std::min(n_workers, kMaxWorkers)) {
+        start_worker_locked();
+    }
+}
+
+int ComputePool::n_workers() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int) workers_.size();
+}
+
+void ComputePool::start_worker_locked() {
+    workers_.emplace_back(&ComputePool::worker_loop, this);
+    LOGI("Compute pool: started worker %zu/%d", workers_.size(), kMaxWorkers);
+}
+
+void ComputePool::worker_loop() {
+    set_openmp_blocktime();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        ++n_idle_;
+        cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        --n_idle_;
+        if (tasks_.empty()) {
+            return;  // stopping
+        }
+
+        std::packaged_task<void()> task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+bool openmp_enabled() {
+#ifdef _OPENMP
+    return true;
+#else
+    return false;
+#endif
+}
+
+void set_openmp_blocktime() {
+#if defined(_OPENMP) && defined(KMP_VERSION_MAJOR)
+    kmp_set_blocktime(kOpenMpBlocktimeMs);
+#endif
+}
+
+} // namespace memex
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+#include <thread>
+
+namespace memex {
+
+// Process-wide set of long-lived threads that run whisper compute for JNI
+// callers. ggml is built with OpenMP, whose runtime keeps a parked team of
+// compute threads per calling thread; running every decode on one of these
+// workers means those teams are started once and reused by each request,
+// instead of once per short-lived Kotlin dispatcher thread (or, without
+// OpenMP, once per graph).
+//
+// Workers are started on demand up to kMaxWorkers and park on a condition
+// variable between requests. Tasks must not wait on other pool tasks.
+class ComputePool {
+public:
+    static constexpr int kMaxWorkers = 8;
+
+    static ComputePool & instance();
+
+    // Queue `task` for a worker. Starts a worker if none is idle.
+    std::future<void> submit(std::function<void()> task);
+
+    // Run `task` on a worker and wait for it.
+    void run(std::function<void()> task) { submit(std::move(task)).wait(); }
+
+    // Start workers until at least `n_workers` exist, e.g. one per decoder
+    // state when a model is loaded.
+    void reserve(int n_workers);
+
+    int n_workers();
+
+private:
+    ComputePool() = default;
+    ~ComputePool();
+
+    void start_worker_locked();
+    void worker_loop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::packaged_task<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    int n_idle_ = 0;
+    bool stopping_ = false;
+};
+
+// Whether ggml's compute threads come from a persistent OpenMP team.
+bool openmp_enabled();
+
+// How long a parked OpenMP team spins after a graph before it sleeps
+// (KMP_BLOCKTIME), in milliseconds. Long enough to bridge the gap between a
+// decode's token graphs; libomp's default of 200 ms would keep every team
+// spinning on its cores well after a request ends.
+constexpr int kOpenMpBlocktimeMs = 1;
+
+// Apply kOpenMpBlocktimeMs to the teams the calling thread starts. A no-op
+// unless the OpenMP runtime is libomp. Pool workers call it on start.
+void set_openmp_blocktime();
+
+} // namespace memex
@@ -0,0 +1,134 @@
+#include "cpu_backend.h"
+
+#include <mutex>
+#include <unistd.h>
+#include "log.h"
+
+#if defined(__aarch64__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+#ifdef MEMEX_CPU_BACKEND_DL
+#include "ggml-backend.h"
+#endif
+
+namespace memex {
+
+std::vector<std::string> CpuFeatures::names() const {
+    std::vector<std::string> out;
+    const std::pair<bool, const char *> flags[] = {
+        {dotprod, "dotprod"}, {fp16, "fp16"}, {i8mm, "i8mm"}, {sve, "sve"},
+        {sse42, "sse4.2"}, {avx, "avx"}, {avx2, "avx2"}, {fma, "fma"}, {f16c, "f16c"},
+        {bmi2, "bmi2"}, {avx512, "avx512"},
+    };
+    for (const auto & flag : flags) {
+        if (flag.first) {
+            out.push_back(flag.second);
+        }
+    }
+    return out;
+}
+
+CpuFeatures detect_cpu_features() {
+    CpuFeatures features;
+#if defined(__aarch64__)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+    features.dotprod = (hwcap & HWCAP_ASIMDDP) != 0;
+    features.fp16    = (hwcap & HWCAP_ASIMDHP) != 0;
+    features.sve     = (hwcap & HWCAP_SVE) != 0;
+#ifdef HWCAP2_I8MM
+    features.i8mm    = (hwcap2 & HWCAP2_I8MM) != 0;
+#else
+    features.i8mm    = (hwcap2 & (1UL << 13)) != 0;
+#endif
+#elif defined(__x86_64__)
+    __builtin_cpu_init();
+    features.sse42  = __builtin_cpu_supports("sse4.2");
+    features.avx    = __builtin_cpu_supports("avx");
+    features.avx2   = __builtin_cpu_supports("avx2");
+    features.fma    = __builtin_cpu_supports("fma");
+    features.f16c   = __builtin_cpu_supports("f16c");
+    features.bmi2   = __builtin_cpu_supports("bmi2");
+    features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+                   && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+#endif
+    return features;
+}
+
+std::vector<std::string> cpu_backend_variants(const CpuFeatures & features) {
+    std::vector<std::string> variants;
+#if defined(__aarch64__)
+    if (features.dotprod && features.fp16 && features.i8mm) {
+        variants.push_back("android_armv8.6_1");
+    }
+    if (features.dotprod && features.fp16) {
+        variants.push_back("android_armv8.2_2");
+    }
+    if (features.dotprod) {
+        variants.push_back("android_armv8.2_1");
+    }
+    variants.push_back("android_armv8.0_1");
+#elif defined(__x86_64__)
+    if (features.avx512 && features.avx2 && features.fma && features.f16c) {
+        variants.push_back("skylakex");
+    }
+    if (features.avx2 && features.fma && features.f16c && features.bmi2) {
+        variants.push_back("haswell");
+    }
+    if (features.avx) {
+        variants.push_back("sandybridge");
+    }
+    if (features.sse42) {
+        variants.push_back("sse42");
+    }
+    variants.push_back("x64");
+#else
+    (void) features;
+#endif
+    return variants;
+}
+
+std::string load_cpu_backend(const std::string & lib_dir) {
+    static std::once_flag once;
+    static std::string loaded;
+
+    std::call_once(once, [&lib_dir] {
+        const CpuFeatures features = detect_cpu_features();
+        std::string names;
+        for (const std::string & name : features.names()) {
+            names += names.empty() ? name : " " + name;
+        }
+        LOGI("CPU features: %s", names.empty() ? "baseline" : names.c_str());
+
+#ifdef MEMEX_CPU_BACKEND_DL
+        for (const std::string & variant : cpu_backend_variants(features)) {
+            const std::string path = lib_dir + "/libggml-cpu-" + variant + ".so";
+            if (access(path.c_str(), R_OK) != 0) {
+                continue;
+            }
+            if (ggml_backend_load(path.c_str()) != nullptr) {
+                loaded = variant;
+                LOGI("Loaded ggml CPU backend %s", variant.c_str());
+                return;
+            }
+            LOGW("Failed to load ggml CPU backend %s", path.c_str());
+        }
+
+        // Variant names differ from the ones expected; let ggml score them
+        ggml_backend_load_all_from_path(lib_dir.c_str());
+        if (ggml_backend_reg_by_name("CPU") != nullptr) {
+            loaded = "ggml";
+            LOGI("Loaded ggml CPU backend chosen by ggml from %s", lib_dir.c_str());
+        } else {
+            LOGE("No ggml CPU backend found in %s", lib_dir.c_str());
+        }
+#else
+        (void) lib_dir;
+#endif
+    });
+    return loaded;
+}
+
+} // namespace memex
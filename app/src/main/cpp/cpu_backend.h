@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace memex {
+
+// Instruction-set extensions relevant to ggml's CPU kernels, read from
+// getauxval(AT_HWCAP/AT_HWCAP2) on arm64 and cpuid on x86-64.
+struct CpuFeatures {
+    // arm64
+    bool dotprod = false;  // SDOT/UDOT (armv8.2)
+    bool fp16 = false;     // half-precision vector arithmetic (armv8.2)
+    bool i8mm = false;     // int8 matrix multiply (armv8.6)
+    bool sve = false;
+
+    // x86-64
+    bool sse42 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool bmi2 = false;
+    bool avx512 = false;   // F, BW, DQ and VL
+
+    // Names of the extensions present, e.g. {"dotprod", "fp16"}.
+    std::vector<std::string> names() const;
+};
+
+CpuFeatures detect_cpu_features();
+
+// ggml CPU backend variants this CPU can run, best first, named as ggml's
+// GGML_CPU_ALL_VARIANTS build names them (libggml-cpu-<variant>.so).
+std::vector<std::string> cpu_backend_variants(const CpuFeatures & features);
+
+// Load the best CPU backend variant found in `lib_dir` (the app's native
+// library directory) before any model is loaded. Falls back to ggml's own
+// scoring over the directory if none of the expected names is present.
+// Runs once per process; later calls return the first result. Returns the
+// variant name, "ggml" for the fallback, or "" when backends are linked in
+// statically or nothing could be loaded.
+std::string load_cpu_backend(const std::string & lib_dir);
+
+} // namespace memex
@@ -0,0 +1,163 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+std::atomic<bool> g_pinning{true};
+
+bool read_int(const std::string & path, int64_t & value) {
+    std::ifstream in(path);
+    return static_cast<bool>(in >> value);
+}
+
+// Parse a sysfs CPU list such as "0-3,6,8-11".
+std::vector<int> parse_cpu_list(const std::string & text) {
+    std::vector<int> ids;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        int first = 0;
+        int last = 0;
+        const int n = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (n < 1) {
+            continue;
+        }
+        if (n == 1) {
+            last = first;
+        }
+        for (int id = first; id <= last; ++id) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+CpuTopology fallback_topology() {
+    CpuTopology topology;
+    const int n_cpus = std::max(1, (int) std::thread::hardware_concurrency());
+    for (int id = 0; id < n_cpus; ++id) {
+        CpuCore core;
+        core.id = id;
+        core.performance = true;
+        topology.cores.push_back(core);
+    }
+    topology.n_clusters = 1;
+    topology.n_performance = n_cpus;
+    return topology;
+}
+
+} // namespace
+
+CpuTopology detect_cpu_topology(const std::string & root) {
+    std::ifstream present(root + "/present");
+    std::string list;
+    if (!std::getline(present, list)) {
+        return fallback_topology();
+    }
+
+    CpuTopology topology;
+    bool have_capacity = false;
+    bool have_freq = false;
+    for (int id : parse_cpu_list(list)) {
+        const std::string dir = root + "/cpu" + std::to_string(id);
+        CpuCore core;
+        core.id = id;
+        int64_t value = 0;
+        if (read_int(dir + "/cpu_capacity", value)) {
+            core.capacity = (int) value;
+            have_capacity = true;
+        }
+        if (read_int(dir + "/cpufreq/cpuinfo_max_freq", value)) {
+            core.max_freq_khz = value;
+            have_freq = true;
+        }
+        topology.cores.push_back(core);
+    }
+    if (topology.cores.empty() || (!have_capacity && !have_freq)) {
+        return fallback_topology();
+    }
+
+    // Clusters: distinct capacities (or max frequencies), slowest first
+    auto key = [have_capacity](const CpuCore & core) {
+        return have_capacity ? (int64_t) core.capacity : core.max_freq_khz;
+    };
+    std::vector<int64_t> keys;
+    for (const CpuCore & core : topology.cores) {
+        keys.push_back(key(core));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    const int64_t fastest = keys.back();
+    for (CpuCore & core : topology.cores) {
+        core.cluster = (int) (std::lower_bound(keys.begin(), keys.end(), key(core)) - keys.begin());
+        core.performance = key(core) * 2 >= fastest;
+        topology.n_performance += core.performance ? 1 : 0;
+    }
+    topology.n_clusters = (int) keys.size();
+    topology.detected = true;
+    return topology;
+}
+
+const CpuTopology & cpu_topology() {
+    static const CpuTopology topology = [] {
+        CpuTopology detected = detect_cpu_topology();
+        LOGI("CPU topology: %zu core(s) in %d cluster(s), %d performance core(s)%s",
+             detected.cores.size(), detected.n_clusters, detected.n_performance,
+             detected.detected ? "" : " (not detected)");
+        return detected;
+    }();
+    return topology;
+}
+
+int default_thread_count() {
+    return std::max(1, cpu_topology().n_performance);
+}
+
+void set_core_pinning(bool enabled) {
+    g_pinning.store(enabled);
+}
+
+bool core_pinning() {
+    return g_pinning.load();
+}
+
+ScopedCorePinning::ScopedCorePinning() {
+    const CpuTopology & topology = cpu_topology();
+    if (!core_pinning() || !topology.detected || topology.n_performance == (int) topology.cores.size()) {
+        return;
+    }
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (const CpuCore & core : topology.cores) {
+        if (core.performance) {
+            CPU_SET(core.id, &mask);
+        }
+    }
+    if (sched_getaffinity(0, sizeof(previous_), &previous_) != 0) {
+        return;
+    }
+    if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+        LOGW("Failed to pin decode thread to performance cores");
+        return;
+    }
+    pinned_ = true;
+}
+
+ScopedCorePinning::~ScopedCorePinning() {
+    if (pinned_) {
+        sched_setaffinity(0, sizeof(previous_), &previous_);
+    }
+}
+
+} // namespace memex
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <sched.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memex {
+
+struct CpuCore {
+    int id = 0;
+    int capacity = 0;           // relative performance (arm64 cpu_capacity, max 1024); 0 if unknown
+    int64_t max_freq_khz = 0;   // cpuinfo_max_freq; 0 if unknown
+    int cluster = 0;            // index of the core's cluster, slowest first
+    bool performance = false;   // in the set decodes are pinned to
+};
+
+// CPU layout read from sysfs. Cores are grouped into clusters by capacity
+// (or maximum frequency where capacity is not exposed). The performance set
+// is every cluster with at least half the capacity of the fastest one, i.e.
+// the big and prime cores of a big.LITTLE layout, or every core when they
+// are all alike.
+struct CpuTopology {
+    std::vector<CpuCore> cores;
+    int n_clusters = 0;
+    int n_performance = 0;
+
+    // Whether sysfs described the cores; if not, `cores` lists every online
+    // core as one cluster and nothing is pinned
+    bool detected = false;
+};
+
+// Parse the layout under `root` (normally /sys/devices/system/cpu).
+CpuTopology detect_cpu_topology(const std::string & root = "/sys/devices/system/cpu");
+
+// The device layout, detected on first use.
+const CpuTopology & cpu_topology();
+
+// Decode threads to use when the caller asks for 0: one per performance core.
+int default_thread_count();
+
+// Resolve a requested thread count; <= 0 means default_thread_count().
+inline int resolve_thread_count(int n_threads) {
+    return n_threads > 0 ? n_threads : default_thread_count();
+}
+
+// Turn pinning to the performance cores on or off process-wide (on by default).
+void set_core_pinning(bool enabled);
+bool core_pinning();
+
+// Pins the calling thread to the performance cores for its lifetime and
+// restores its previous affinity afterwards. Threads it starts meanwhile,
+// including ggml's compute workers, inherit the mask. Does nothing when
+// pinning is off, the topology is unknown or every core is a performance core.
+class ScopedCorePinning {
+public:
+    ScopedCorePinning();
+    ~ScopedCorePinning();
+
+    ScopedCorePinning(const ScopedCorePinning &) = delete;
+    ScopedCorePinning & operator=(const ScopedCorePinning &) = delete;
+
+    bool pinned() const { return pinned_; }
+
+private:
+    bool pinned_ = false;
+    cpu_set_t previous_;
+};
+
+} // namespace memex
@@ -0,0 +1,48 @@
+#include "decode_profile.h"
+
+#include <array>
+#include "cpu_topology.h"
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+whisper_full_params build_params(const DecodeProfile & profile) {
+    whisper_full_params wparams = whisper_full_default_params(profile.strategy);
+    wparams.print_progress   = false;
+    wparams.print_special    = false;
+    wparams.print_realtime   = false;
+    wparams.print_timestamps = false;
+    wparams.translate        = false;
+    wparams.language         = profile.language;
+    wparams.offset_ms        = 0;
+    wparams.duration_ms      = 0;
+    wparams.single_segment   = profile.single_segment;
+    wparams.no_context       = profile.no_context;
+    wparams.no_timestamps    = profile.no_timestamps;
+    wparams.max_tokens       = profile.max_tokens;
+    wparams.audio_ctx        = 0;
+    return wparams;
+}
+
+} // namespace
+
+whisper_full_params full_params_for(int id, int n_threads) {
+    static const std::array<whisper_full_params, PROFILE_COUNT> params = [] {
+        std::array<whisper_full_params, PROFILE_COUNT> built;
+        for (int i = 0; i < PROFILE_COUNT; ++i) {
+            built[i] = build_params(kDecodeProfiles[i]);
+        }
+        return built;
+    }();
+
+    if (!is_valid_profile(id)) {
+        LOGW("Unknown decode profile %d, using default", id);
+    }
+    whisper_full_params wparams = params[decode_profile(id).id];
+    wparams.n_threads = resolve_thread_count(n_threads);
+    return wparams;
+}
+
+} // namespace memex
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "whisper.h"
+
+namespace memex {
+
+// Decode profile ids, shared with Kotlin (WhisperService.DecodeProfile).
+enum DecodeProfileId : int {
+    PROFILE_DEFAULT   = 0,  // general transcription, timestamps on
+    PROFILE_COMMAND   = 1,  // short voice commands
+    PROFILE_DICTATION = 2,  // continuous dictation, context carried across windows
+    PROFILE_LONG_FORM = 3,  // independent chunks of a long recording
+    PROFILE_STREAMING = 4,  // sliding-window streaming steps
+    PROFILE_COUNT
+};
+
+struct DecodeProfile {
+    DecodeProfileId id;
+    const char * name;
+    enum whisper_sampling_strategy strategy;
+    const char * language;
+    bool single_segment;
+    bool no_context;          // do not condition on the previous window's text
+    bool no_timestamps;
+    int  max_tokens;          // per segment, 0 = no limit
+    bool adaptive_audio_ctx;  // size the encoder context to the clip
+    bool use_grammar;         // constrain to the service's command grammar, if set
+};
+
+constexpr DecodeProfile kDecodeProfiles[PROFILE_COUNT] = {
+    // id                name         strategy                 lang  single no_ctx no_ts max_tok adaptive grammar
+    { PROFILE_DEFAULT,   "default",   WHISPER_SAMPLING_GREEDY, "en", false, true,  false, 0,      false,   false },
+    { PROFILE_COMMAND,   "command",   WHISPER_SAMPLING_GREEDY, "en", true,  true,  true,  32,     true,    true  },
+    { PROFILE_DICTATION, "dictation", WHISPER_SAMPLING_GREEDY, "en", false, false, false, 0,      false,   false },
+    { PROFILE_LONG_FORM, "long-form", WHISPER_SAMPLING_GREEDY, "en", false, true,  false, 0,      false,   false },
+    { PROFILE_STREAMING, "streaming", WHISPER_SAMPLING_GREEDY, "en", true,  true,  true,  32,     false,   false },
+};
+
+constexpr bool profiles_indexed_by_id() {
+    for (int i = 0; i < PROFILE_COUNT; ++i) {
+        if (kDecodeProfiles[i].id != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(profiles_indexed_by_id(), "kDecodeProfiles must be ordered by id");
+
+constexpr bool is_valid_profile(int id) {
+    return id >= 0 && id < PROFILE_COUNT;
+}
+
+// Profile for `id`; unknown ids get the default profile.
+constexpr const DecodeProfile & decode_profile(int id) {
+    return kDecodeProfiles[is_valid_profile(id) ? id : PROFILE_DEFAULT];
+}
+
+// whisper_full_params for a profile. Each profile's params are built once on
+// first use; requests get a copy with only the thread count filled in.
+whisper_full_params full_params_for(int id, int n_threads);
+
+} // namespace memex
@@ -0,0 +1,282 @@
+#include "grammar.h"
+
+#include <stdexcept>
+
+namespace memex {
+
+namespace {
+
+using Elements = std::vector<whisper_grammar_element>;
+
+bool is_word_char(char c) {
+    return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '-' || ('0' <= c && c <= '9');
+}
+
+const char * skip_space(const char * pos, bool newline_ok) {
+    while (*pos == ' ' || *pos == '\t' || *pos == '#' || (newline_ok && (*pos == '\r' || *pos == '\n'))) {
+        if (*pos == '#') {
+            while (*pos && *pos != '\r' && *pos != '\n') {
+                ++pos;
+            }
+        } else {
+            ++pos;
+        }
+    }
+    return pos;
+}
+
+const char * parse_name(const char * pos) {
+    const char * end = pos;
+    while (is_word_char(*end)) {
+        ++end;
+    }
+    if (end == pos) {
+        throw std::runtime_error(std::string("expecting name at ") + pos);
+    }
+    return end;
+}
+
+// Decode one UTF-8 code point; returns the position after it.
+const char * decode_utf8(const char * pos, uint32_t & code_point) {
+    static const int lengths[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 4};
+    const uint8_t first = (uint8_t) *pos;
+    const int len = lengths[first >> 4];
+    const uint8_t mask = (uint8_t) ((1 << (8 - len)) - 1);
+    code_point = first & mask;
+    ++pos;
+    for (int i = 1; i < len && *pos; ++i, ++pos) {
+        code_point = (code_point << 6) | ((uint8_t) *pos & 0x3F);
+    }
+    return pos;
+}
+
+const char * parse_hex(const char * pos, int size, uint32_t & value) {
+    value = 0;
+    for (int i = 0; i < size; ++i, ++pos) {
+        const char c = *pos;
+        value <<= 4;
+        if ('a' <= c && c <= 'f') {
+            value += c - 'a' + 10;
+        } else if ('A' <= c && c <= 'F') {
+            value += c - 'A' + 10;
+        } else if ('0' <= c && c <= '9') {
+            value += c - '0';
+        } else {
+            throw std::runtime_error("invalid hex escape");
+        }
+    }
+    return pos;
+}
+
+const char * parse_char(const char * pos, uint32_t & code_point) {
+    if (*pos != '\\') {
+        return decode_utf8(pos, code_point);
+    }
+    switch (pos[1]) {
+        case 'x': return parse_hex(pos + 2, 2, code_point);
+        case 'u': return parse_hex(pos + 2, 4, code_point);
+        case 't': code_point = '\t'; return pos + 2;
+        case 'r': code_point = '\r'; return pos + 2;
+        case 'n': code_point = '\n'; return pos + 2;
+        case '\\':
+        case '"':
+        case '[':
+        case ']':
+            code_point = (uint8_t) pos[1];
+            return pos + 2;
+        default:
+            throw std::runtime_error(std::string("unknown escape at ") + pos);
+    }
+}
+
+} // namespace
+
+uint32_t Grammar::symbol_id(const std::string & name) {
+    const uint32_t next_id = (uint32_t) symbol_ids_.size();
+    return symbol_ids_.emplace(name, next_id).first->second;
+}
+
+uint32_t Grammar::generate_symbol_id(const std::string & base) {
+    const uint32_t next_id = (uint32_t) symbol_ids_.size();
+    symbol_ids_[base + '_' + std::to_string(next_id)] = next_id;
+    return next_id;
+}
+
+void Grammar::add_rule(uint32_t id, const Elements & rule) {
+    if (rules_.size() <= id) {
+        rules_.resize(id + 1);
+    }
+    rules_[id] = rule;
+}
+
+const char * Grammar::parse_sequence(const char * pos, const std::string & rule_name, Elements & out, bool is_nested) {
+    size_t last_sym_start = out.size();
+    while (*pos) {
+        if (*pos == '"') {
+            // String literal: one CHAR per code point
+            ++pos;
+            last_sym_start = out.size();
+            while (*pos != '"') {
+                if (*pos == '\0') {
+                    throw std::runtime_error("unexpected end of input in string literal");
+                }
+                uint32_t code_point;
+                pos = parse_char(pos, code_point);
+                out.push_back({WHISPER_GRETYPE_CHAR, code_point});
+            }
+            pos = skip_space(pos + 1, is_nested);
+        } else if (*pos == '[') {
+            // Character class
+            ++pos;
+            enum whisper_gretype start_type = WHISPER_GRETYPE_CHAR;
+            if (*pos == '^') {
+                ++pos;
+                start_type = WHISPER_GRETYPE_CHAR_NOT;
+            }
+            last_sym_start = out.size();
+            while (*pos != ']') {
+                if (*pos == '\0') {
+                    throw std::runtime_error("unexpected end of input in character class");
+                }
+                uint32_t code_point;
+                pos = parse_char(pos, code_point);
+                const enum whisper_gretype type = last_sym_start < out.size() ? WHISPER_GRETYPE_CHAR_ALT : start_type;
+                out.push_back({type, code_point});
+                if (pos[0] == '-' && pos[1] != ']') {
+                    uint32_t upper;
+                    pos = parse_char(pos + 1, upper);
+                    out.push_back({WHISPER_GRETYPE_CHAR_RNG_UPPER, upper});
+                }
+            }
+            pos = skip_space(pos + 1, is_nested);
+        } else if (is_word_char(*pos)) {
+            // Rule reference
+            const char * name_end = parse_name(pos);
+            const uint32_t ref_id = symbol_id(std::string(pos, name_end - pos));
+            last_sym_start = out.size();
+            out.push_back({WHISPER_GRETYPE_RULE_REF, ref_id});
+            pos = skip_space(name_end, is_nested);
+        } else if (*pos == '(') {
+            // Group: becomes a generated rule
+            const uint32_t sub_id = generate_symbol_id(rule_name);
+            pos = parse_alternates(skip_space(pos + 1, true), rule_name, sub_id, true);
+            last_sym_start = out.size();
+            out.push_back({WHISPER_GRETYPE_RULE_REF, sub_id});
+            if (*pos != ')') {
+                throw std::runtime_error(std::string("expecting ')' at ") + pos);
+            }
+            pos = skip_space(pos + 1, is_nested);
+        } else if (*pos == '*' || *pos == '+' || *pos == '?') {
+            if (last_sym_start == out.size()) {
+                throw std::runtime_error(std::string("expecting preceding item to */+/? at ") + pos);
+            }
+
+            // Rewrite the preceding item S as a generated rule:
+            //   S* --> sub ::= S sub |
+            //   S+ --> sub ::= S sub | S
+            //   S? --> sub ::= S |
+            const uint32_t sub_id = generate_symbol_id(rule_name);
+            Elements sub_rule(out.begin() + last_sym_start, out.end());
+            if (*pos == '*' || *pos == '+') {
+                sub_rule.push_back({WHISPER_GRETYPE_RULE_REF, sub_id});
+            }
+            sub_rule.push_back({WHISPER_GRETYPE_ALT, 0});
+            if (*pos == '+') {
+                sub_rule.insert(sub_rule.end(), out.begin() + last_sym_start, out.end());
+            }
+            sub_rule.push_back({WHISPER_GRETYPE_END, 0});
+            add_rule(sub_id, sub_rule);
+
+            out.resize(last_sym_start);
+            out.push_back({WHISPER_GRETYPE_RULE_REF, sub_id});
+            pos = skip_space(pos + 1, is_nested);
+        } else {
+            break;
+        }
+    }
+    return pos;
+}
+
+const char * Grammar::parse_alternates(const char * pos, const std::string & rule_name, uint32_t rule_id, bool is_nested) {
+    Elements rule;
+    pos = parse_sequence(pos, rule_name, rule, is_nested);
+    while (*pos == '|') {
+        rule.push_back({WHISPER_GRETYPE_ALT, 0});
+        pos = parse_sequence(skip_space(pos + 1, true), rule_name, rule, is_nested);
+    }
+    rule.push_back({WHISPER_GRETYPE_END, 0});
+    add_rule(rule_id, rule);
+    return pos;
+}
+
+bool Grammar::parse(const std::string & text, std::string * error) {
+    symbol_ids_.clear();
+    rules_.clear();
+    rule_ptrs_.clear();
+
+    try {
+        const char * pos = skip_space(text.c_str(), true);
+        while (*pos) {
+            const char * name_end = parse_name(pos);
+            const std::string name(pos, name_end - pos);
+            pos = skip_space(name_end, false);
+            if (!(pos[0] == ':' && pos[1] == ':' && pos[2] == '=')) {
+                throw std::runtime_error(std::string("expecting ::= at ") + pos);
+            }
+            pos = parse_alternates(skip_space(pos + 3, true), name, symbol_id(name), false);
+
+            if (*pos == '\r') {
+                pos += pos[1] == '\n' ? 2 : 1;
+            } else if (*pos == '\n') {
+                ++pos;
+            } else if (*pos) {
+                throw std::runtime_error(std::string("expecting newline or end at ") + pos);
+            }
+            pos = skip_space(pos, true);
+        }
+
+        // Every referenced rule must be defined
+        for (const Elements & rule : rules_) {
+            for (const whisper_grammar_element & elem : rule) {
+                if (elem.type == WHISPER_GRETYPE_RULE_REF
+                        && (elem.value >= rules_.size() || rules_[elem.value].empty())) {
+                    for (const auto & symbol : symbol_ids_) {
+                        if (symbol.second == elem.value) {
+                            throw std::runtime_error("undefined rule identifier '" + symbol.first + "'");
+                        }
+                    }
+                }
+            }
+        }
+
+        const auto root = symbol_ids_.find("root");
+        if (root == symbol_ids_.end()) {
+            throw std::runtime_error("grammar does not define 'root'");
+        }
+        root_id_ = root->second;
+    } catch (const std::exception & e) {
+        if (error != nullptr) {
+            *error = e.what();
+        }
+        symbol_ids_.clear();
+        rules_.clear();
+        return false;
+    }
+
+    for (const Elements & rule : rules_) {
+        rule_ptrs_.push_back(rule.data());
+    }
+    return true;
+}
+
+void Grammar::apply(whisper_full_params & wparams, float penalty) const {
+    if (rules_.empty()) {
+        return;
+    }
+    wparams.grammar_rules   = const_cast<const whisper_grammar_element **>(rule_ptrs_.data());
+    wparams.n_grammar_rules = rule_ptrs_.size();
+    wparams.i_start_rule    = root_id_;
+    wparams.grammar_penalty = penalty;
+}
+
+} // namespace memex
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "whisper.h"
+
+namespace memex {
+
+// A GBNF grammar compiled to whisper.cpp's grammar rule format, for
+// constraining decoding through whisper_full_params::grammar_rules.
+//
+// Supported syntax is the common GBNF subset: `name ::= ...` rules, string
+// literals, character classes ([a-z], [^...]), rule references, grouping,
+// alternation and the *, + and ? operators, with # comments.
+class Grammar {
+public:
+    // Parse `text`. On failure returns false and describes the problem in `error`.
+    bool parse(const std::string & text, std::string * error = nullptr);
+
+    // Point `wparams` at this grammar, starting from rule `root`. The grammar
+    // must outlive the decode. `penalty` is subtracted from the logits of
+    // tokens the grammar does not allow.
+    void apply(whisper_full_params & wparams, float penalty) const;
+
+    bool empty() const { return rules_.empty(); }
+    size_t n_rules() const { return rules_.size(); }
+
+private:
+    uint32_t symbol_id(const std::string & name);
+    uint32_t generate_symbol_id(const std::string & base);
+    void add_rule(uint32_t id, const std::vector<whisper_grammar_element> & rule);
+
+    const char * parse_alternates(const char * pos, const std::string & rule_name, uint32_t rule_id, bool is_nested);
+    const char * parse_sequence(const char * pos, const std::string & rule_name,
+                                std::vector<whisper_grammar_element> & out, bool is_nested);
+
+    std::map<std::string, uint32_t> symbol_ids_;
+    std::vector<std::vector<whisper_grammar_element>> rules_;
+    std::vector<const whisper_grammar_element *> rule_ptrs_;
+    uint32_t root_id_ = 0;
+};
+
+} // namespace memex
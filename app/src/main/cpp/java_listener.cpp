@@ -0,0 +1,114 @@
+#include "java_listener.h"
+
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+JavaVM * g_vm = nullptr;
+jmethodID g_on_segment = nullptr;
+jmethodID g_on_progress = nullptr;
+
+// Detaches threads that attached_env() attached, when they exit
+struct ThreadAttachment {
+    JNIEnv * env = nullptr;
+    bool attached = false;
+
+    ~ThreadAttachment() {
+        if (attached && g_vm != nullptr) {
+            g_vm->DetachCurrentThread();
+        }
+    }
+};
+
+thread_local ThreadAttachment t_attachment;
+
+void clear_listener_exception(JNIEnv * env, const char * method) {
+    if (env->ExceptionCheck()) {
+        LOGW("TranscriptionListener.%s threw; ignoring", method);
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+} // namespace
+
+bool init_transcription_listener(JavaVM * vm, JNIEnv * env) {
+    g_vm = vm;
+
+    jclass listener_class = env->FindClass("com/memexagent/app/whisper/TranscriptionListener");
+    if (listener_class == nullptr) {
+        env->ExceptionClear();
+        LOGE("TranscriptionListener class not found; listeners disabled");
+        return false;
+    }
+    g_on_segment  = env->GetMethodID(listener_class, "onSegment", "(IJJLjava/lang/String;)V");
+    g_on_progress = env->GetMethodID(listener_class, "onProgress", "(I)V");
+    env->DeleteLocalRef(listener_class);
+
+    if (g_on_segment == nullptr || g_on_progress == nullptr) {
+        env->ExceptionClear();
+        g_on_segment = nullptr;
+        g_on_progress = nullptr;
+        LOGE("TranscriptionListener methods not found; listeners disabled");
+        return false;
+    }
+    return true;
+}
+
+JNIEnv * attached_env() {
+    if (t_attachment.env != nullptr) {
+        return t_attachment.env;
+    }
+    if (g_vm == nullptr) {
+        return nullptr;
+    }
+
+    JNIEnv * env = nullptr;
+    const jint status = g_vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
+    if (status == JNI_EDETACHED) {
+        JavaVMAttachArgs args{JNI_VERSION_1_6, "whisper-decode", nullptr};
+        if (g_vm->AttachCurrentThread(&env, &args) != JNI_OK) {
+            LOGE("Failed to attach decode thread to the JVM");
+            return nullptr;
+        }
+        t_attachment.attached = true;
+    } else if (status != JNI_OK) {
+        return nullptr;
+    }
+    t_attachment.env = env;
+    return env;
+}
+
+JavaTranscriptionListener::JavaTranscriptionListener(JNIEnv * env, jobject listener)
+    : listener_(env->NewGlobalRef(listener)) {}
+
+JavaTranscriptionListener::~JavaTranscriptionListener() {
+    JNIEnv * env = attached_env();
+    if (env != nullptr) {
+        env->DeleteGlobalRef(listener_);
+    }
+}
+
+void JavaTranscriptionListener::on_segment(int index, int64_t t0_ms, int64_t t1_ms, const char * text) const {
+    JNIEnv * env = attached_env();
+    if (env == nullptr || g_on_segment == nullptr) {
+        return;
+    }
+    jstring jtext = env->NewStringUTF(text ? text : "");
+    env->CallVoidMethod(listener_, g_on_segment, (jint) index, (jlong) t0_ms, (jlong) t1_ms, jtext);
+    clear_listener_exception(env, "onSegment");
+    env->DeleteLocalRef(jtext);
+}
+
+void JavaTranscriptionListener::on_progress(int percent) const {
+    JNIEnv * env = attached_env();
+    if (env == nullptr || g_on_progress == nullptr) {
+        return;
+    }
+    env->CallVoidMethod(listener_, g_on_progress, (jint) percent);
+    clear_listener_exception(env, "onProgress");
+}
+
+} // namespace memex
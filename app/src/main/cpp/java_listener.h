@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <jni.h>
+#include "transcription_listener.h"
+
+namespace memex {
+
+// Cache the JavaVM and the TranscriptionListener method IDs. Call from
+// JNI_OnLoad: classes can only be found through the app class loader there,
+// not from native decode threads.
+bool init_transcription_listener(JavaVM * vm, JNIEnv * env);
+
+// JNIEnv for the calling thread. Native threads are attached on first use and
+// detached automatically when they exit. Returns nullptr before
+// init_transcription_listener() or if attaching fails.
+JNIEnv * attached_env();
+
+// A Kotlin TranscriptionListener held through a global reference. Calls are
+// made on whatever thread produces the result; exceptions thrown by the
+// listener are logged and cleared so they never unwind into the decoder.
+class JavaTranscriptionListener final : public TranscriptionListener {
+public:
+    JavaTranscriptionListener(JNIEnv * env, jobject listener);
+    ~JavaTranscriptionListener() override;
+
+    void on_segment(int index, int64_t t0_ms, int64_t t1_ms, const char * text) const override;
+    void on_progress(int percent) const override;
+
+private:
+    jobject listener_;
+};
+
+} // namespace memex
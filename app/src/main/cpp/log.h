@@ -0,0 +1,45 @@
+#pragma once
+
+#define LOG_TAG "WhisperJNI"
+
+#ifdef __ANDROID__
+
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+#else
+
+// Host builds (memex-cli) log to stderr
+#include <cstdarg>
+#include <cstdio>
+
+namespace memex {
+
+enum LogLevel { LOG_LEVEL_INFO = 0, LOG_LEVEL_WARN = 1, LOG_LEVEL_ERROR = 2, LOG_LEVEL_NONE = 3 };
+
+// Messages below this level are dropped
+inline LogLevel host_log_level = LOG_LEVEL_INFO;
+
+inline void host_log(LogLevel level, const char * fmt, ...) {
+    if (level < host_log_level) {
+        return;
+    }
+    static const char kLevels[] = {'I', 'W', 'E'};
+    std::fprintf(stderr, "%c/%s: ", kLevels[level], LOG_TAG);
+    va_list args;
+    va_start(args, fmt);
+    std::vfprintf(stderr, fmt, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+}
+
+} // namespace memex
+
+#define LOGI(...) memex::host_log(memex::LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOGW(...) memex::host_log(memex::LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOGE(...) memex::host_log(memex::LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
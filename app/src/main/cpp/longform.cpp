@@ -0,0 +1,211 @@
+#include "longform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <mutex>
+#include "compute_pool.h"
+#include "cpu_topology.h"
+#include "log.h"
+#include "state_pool.h"
+
+namespace memex {
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Decode one chunk on `state` and append the segments it owns to `out`.
+void decode_chunk(const Model & model, struct whisper_state * state, whisper_full_params wparams,
+                  const float * samples, const LongFormChunk & chunk, int sample_rate,
+                  ChunkStats & stats, std::vector<TranscriptSegment> & out) {
+    const int64_t offset_ms     = chunk.start * 1000 / sample_rate;
+    const int64_t core_start_ms = chunk.core_start * 1000 / sample_rate;
+    const int64_t core_end_ms   = chunk.core_end * 1000 / sample_rate;
+
+    stats.start_ms  = offset_ms;
+    stats.end_ms    = chunk.end * 1000 / sample_rate;
+    stats.n_threads = wparams.n_threads;
+
+    const auto t_start = std::chrono::steady_clock::now();
+    stats.status = whisper_full_with_state(model.ctx, state, wparams, samples + chunk.start,
+                                           (int) (chunk.end - chunk.start));
+    stats.decode_ms = elapsed_ms(t_start);
+
+    const double audio_ms = (double) (stats.end_ms - stats.start_ms);
+    stats.rtf = audio_ms > 0.0 ? stats.decode_ms / audio_ms : 0.0;
+
+    if (stats.status != 0) {
+        LOGE("Chunk [%lld, %lld) ms failed, error code: %d",
+             (long long) stats.start_ms, (long long) stats.end_ms, stats.status);
+        return;
+    }
+
+    LOGI("Chunk [%lld, %lld) ms decoded in %.0f ms on %d threads, RTF %.3f",
+         (long long) stats.start_ms, (long long) stats.end_ms, stats.decode_ms, stats.n_threads, stats.rtf);
+
+    // Segment times are relative to the chunk start
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; ++i) {
+        TranscriptSegment seg = segment_from_state(model.ctx, state, i);
+        seg.t0_ms += offset_ms;
+        seg.t1_ms += offset_ms;
+
+        const int64_t mid_ms = (seg.t0_ms + seg.t1_ms) / 2;
+        if (mid_ms < core_start_ms || mid_ms >= core_end_ms) {
+            continue;  // decoded from overlap; the neighbouring chunk owns it
+        }
+        out.push_back(std::move(seg));
+    }
+}
+
+} // namespace
+
+std::vector<LongFormChunk> plan_chunks(const float * samples, size_t n_samples,
+                                       const LongFormParams & params) {
+    const int sample_rate = params.vad.sample_rate;
+    const int64_t max_chunk = std::max<int64_t>(1, (int64_t) params.max_chunk_ms * sample_rate / 1000);
+    const int64_t overlap   = std::max<int64_t>(0, (int64_t) params.overlap_ms * sample_rate / 1000);
+
+    // Split speech segments that do not fit in one chunk into equal pieces
+    std::vector<SpeechSegment> pieces;
+    for (const SpeechSegment & seg : detect_speech(samples, n_samples, params.vad)) {
+        const int64_t n_pieces = (seg.length() + max_chunk - 1) / max_chunk;
+        const int64_t piece_len = (seg.length() + n_pieces - 1) / n_pieces;
+        for (int64_t start = seg.start; start < seg.end; start += piece_len) {
+            pieces.push_back({start, std::min(seg.end, start + piece_len)});
+        }
+    }
+
+    // Greedily pack consecutive pieces into spans of at most max_chunk
+    std::vector<SpeechSegment> spans;
+    for (const SpeechSegment & piece : pieces) {
+        if (!spans.empty() && piece.end - spans.back().start <= max_chunk) {
+            spans.back().end = piece.end;
+        } else {
+            spans.push_back(piece);
+        }
+    }
+
+    std::vector<LongFormChunk> chunks;
+    chunks.reserve(spans.size());
+    for (size_t i = 0; i < spans.size(); ++i) {
+        LongFormChunk chunk;
+        chunk.start      = std::max<int64_t>(0, spans[i].start - overlap);
+        chunk.end        = std::min<int64_t>((int64_t) n_samples, spans[i].end + overlap);
+        chunk.core_start = i == 0 ? 0 : (spans[i - 1].end + spans[i].start) / 2;
+        chunk.core_end   = i + 1 == spans.size() ? (int64_t) n_samples : (spans[i].end + spans[i + 1].start) / 2;
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+LongFormResult transcribe_long(const std::shared_ptr<Model> & model,
+                               const whisper_full_params & base,
+                               const float * samples, size_t n_samples,
+                               const LongFormParams & params) {
+    const auto t_start = std::chrono::steady_clock::now();
+    const int sample_rate = params.vad.sample_rate;
+
+    LongFormResult result;
+    const std::vector<LongFormChunk> chunks = plan_chunks(samples, n_samples, params);
+    if (chunks.empty()) {
+        LOGI("Long-form: no speech in %zu samples", n_samples);
+        result.ok = true;
+        return result;
+    }
+
+    // One leased state per worker. The first lease may wait; extra workers
+    // only use states that are free right now, so a long recording never
+    // starves concurrent short requests.
+    StatePool * pool = model->states.get();
+    const int n_wanted = std::min<int>(params.n_workers > 0 ? params.n_workers : pool->max_states(),
+                                       (int) chunks.size());
+    std::vector<StateLease> leases;
+    leases.emplace_back(pool, pool->acquire());
+    if (!leases.front()) {
+        LOGE("No decoder state available");
+        return result;
+    }
+    while ((int) leases.size() < n_wanted) {
+        struct whisper_state * state = pool->try_acquire();
+        if (state == nullptr) {
+            break;
+        }
+        leases.emplace_back(pool, state);
+    }
+    const int n_workers = (int) leases.size();
+
+    const int n_threads_total = resolve_thread_count(params.n_threads);
+
+    whisper_full_params wparams = base;
+    wparams.n_threads       = std::max(1, n_threads_total / n_workers);
+    wparams.no_context      = true;  // chunks are decoded independently
+    wparams.no_timestamps   = false; // needed to stitch
+    wparams.single_segment  = false;
+    wparams.offset_ms       = 0;
+    wparams.duration_ms     = 0;
+    wparams.prompt_tokens   = nullptr;
+    wparams.prompt_n_tokens = 0;
+
+    LOGI("Long-form: %zu chunk(s) over %.1f s on %d worker(s) x %d thread(s)",
+         chunks.size(), (double) n_samples / sample_rate, n_workers, wparams.n_threads);
+
+    // Workers pull chunk indices in order and write only to their own slots
+    std::vector<std::vector<TranscriptSegment>> chunk_segments(chunks.size());
+    result.chunks.resize(chunks.size());
+    std::atomic<size_t> next_chunk{0};
+    std::mutex callback_mutex;
+    int n_done = 0;
+
+    auto worker = [&](const StateLease & lease) {
+        ScopedCorePinning pinning;
+        for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            // Leave the remaining chunks undecoded once the request is aborted
+            if (wparams.abort_callback != nullptr && wparams.abort_callback(wparams.abort_callback_user_data)) {
+                result.chunks[i].status = -1;
+                continue;
+            }
+            decode_chunk(*model, lease.get(), wparams, samples, chunks[i], sample_rate,
+                         result.chunks[i], chunk_segments[i]);
+
+            if (params.on_segment || params.on_chunk_done) {
+                std::lock_guard<std::mutex> lock(callback_mutex);
+                if (params.on_segment) {
+                    for (const TranscriptSegment & seg : chunk_segments[i]) {
+                        params.on_segment(seg);
+                    }
+                }
+                if (params.on_chunk_done) {
+                    params.on_chunk_done(++n_done, (int) chunks.size());
+                }
+            }
+        }
+    };
+
+    // Workers run on the persistent compute pool, so their OpenMP teams are reused
+    std::vector<std::future<void>> done;
+    for (int w = 0; w < n_workers; ++w) {
+        done.push_back(ComputePool::instance().submit([&worker, &leases, w] { worker(leases[w]); }));
+    }
+    for (std::future<void> & f : done) {
+        f.wait();
+    }
+
+    result.ok = std::all_of(result.chunks.begin(), result.chunks.end(),
+                            [](const ChunkStats & stats) { return stats.status == 0; });
+    for (std::vector<TranscriptSegment> & segs : chunk_segments) {
+        std::move(segs.begin(), segs.end(), std::back_inserter(result.segments));
+    }
+
+    result.wall_ms = elapsed_ms(t_start);
+    const double audio_ms = 1000.0 * n_samples / sample_rate;
+    LOGI("Long-form: %zu segment(s) in %.0f ms, overall RTF %.3f",
+         result.segments.size(), result.wall_ms, audio_ms > 0.0 ? result.wall_ms / audio_ms : 0.0);
+    return result;
+}
+
+} // namespace memex
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "model_registry.h"
+#include "transcript.h"
+#include "vad.h"
+#include "whisper.h"
+
+namespace memex {
+
+struct LongFormParams {
+    int max_chunk_ms = 25000;  // chunks stay inside one 30 s encoder window
+    int overlap_ms   = 500;    // extra audio decoded on each side of a chunk
+    int n_workers    = 0;      // concurrent chunks, 0 = as many as the state pool allows
+    int n_threads    = 0;      // total decode threads, 0 = one per performance core
+    VadParams vad;
+
+    // Optional: called with each stitched segment as soon as its chunk is
+    // decoded, and with the number of chunks finished so far. Chunks finish
+    // in any order; calls are serialised across workers.
+    std::function<void(const TranscriptSegment &)> on_segment;
+    std::function<void(int done, int total)> on_chunk_done;
+};
+
+// A chunk of the source clip, in samples. [start, end) is what gets decoded;
+// [core_start, core_end) is the part this chunk owns when stitching, so chunks
+// partition the clip even when their decoded ranges overlap.
+struct LongFormChunk {
+    int64_t start = 0;
+    int64_t end = 0;
+    int64_t core_start = 0;
+    int64_t core_end = 0;
+};
+
+struct ChunkStats {
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    double decode_ms = 0.0;
+    double rtf = 0.0;  // decode time / audio time
+    int n_threads = 0;
+    int status = 0;    // whisper_full return code
+};
+
+struct LongFormResult {
+    bool ok = false;
+    std::vector<TranscriptSegment> segments;
+    std::vector<ChunkStats> chunks;
+    double wall_ms = 0.0;
+};
+
+// Split a clip at VAD pauses into chunks of at most `max_chunk_ms` of speech
+// (plus overlap). Cuts fall in the middle of the silence between speech
+// segments; a single segment longer than the limit is split evenly.
+std::vector<LongFormChunk> plan_chunks(const float * samples, size_t n_samples,
+                                       const LongFormParams & params);
+
+// Transcribe a long clip by decoding its chunks concurrently, each on its own
+// leased decoder state with n_threads / n_workers threads, then stitch the
+// segments back in order with timestamps relative to the clip. A decoded
+// segment is kept by the chunk whose core range contains its midpoint, which
+// drops the duplicates produced by overlap. `base` supplies the decode
+// parameters; threading and context carry-over are overridden per chunk.
+LongFormResult transcribe_long(const std::shared_ptr<Model> & model,
+                               const whisper_full_params & base,
+                               const float * samples, size_t n_samples,
+                               const LongFormParams & params);
+
+} // namespace memex
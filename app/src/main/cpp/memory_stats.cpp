@@ -0,0 +1,191 @@
+#include "memory_stats.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include "log.h"
+#include "model_registry.h"
+#include "whisper.h"
+
+namespace memex {
+
+namespace {
+
+thread_local BufferSizeCapture * t_capture = nullptr;
+
+// whisper.cpp log labels, e.g.
+//   whisper_model_load: model size    =  147.37 MB
+//   whisper_init_state: kv self size  =    6.29 MB
+//   whisper_init_state: compute buffer (encode) =   85.86 MB
+struct SizeLabel {
+    const char * label;
+    int64_t WhisperBufferSizes::* field;
+    bool accumulate;  // several lines add up (one per compute graph)
+};
+
+constexpr SizeLabel kSizeLabels[] = {
+    {"model size",     &WhisperBufferSizes::weights,  false},
+    {"kv self size",   &WhisperBufferSizes::kv_self,  false},
+    {"kv cross size",  &WhisperBufferSizes::kv_cross, false},
+    {"kv pad",         &WhisperBufferSizes::kv_pad,   false},
+    {"compute buffer", &WhisperBufferSizes::compute,  true},
+};
+
+// Bytes in "=  12.34 MB" following `from`, or -1
+int64_t parse_size(const char * from) {
+    const char * eq = std::strchr(from, '=');
+    if (eq == nullptr) {
+        return -1;
+    }
+    char * end = nullptr;
+    const double value = std::strtod(eq + 1, &end);
+    if (end == eq + 1) {
+        return -1;
+    }
+    while (*end == ' ') {
+        ++end;
+    }
+    if (std::strncmp(end, "MiB", 3) == 0) {
+        return (int64_t) (value * 1024.0 * 1024.0);
+    }
+    if (std::strncmp(end, "MB", 2) == 0) {
+        return (int64_t) (value * 1e6);  // whisper.cpp's MB are 10^6 bytes
+    }
+    return -1;
+}
+
+void whisper_log_hook(enum ggml_log_level level, const char * text, void * /* user_data */) {
+    if (text == nullptr || level == GGML_LOG_LEVEL_DEBUG || level == GGML_LOG_LEVEL_CONT) {
+        return;
+    }
+    BufferSizeCapture::on_log_line(text);
+
+    size_t len = std::strlen(text);
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r')) {
+        --len;
+    }
+    if (len == 0) {
+        return;
+    }
+    if (level == GGML_LOG_LEVEL_ERROR) {
+        LOGE("%.*s", (int) len, text);
+    } else if (level == GGML_LOG_LEVEL_WARN) {
+        LOGW("%.*s", (int) len, text);
+    } else {
+        LOGI("%.*s", (int) len, text);
+    }
+}
+
+// Total of all states given one state's size, or -1 if unknown
+int64_t all_states(int64_t per_state, int n_states) {
+    return per_state < 0 ? -1 : per_state * n_states;
+}
+
+// Value in kB of a "Key:   1234 kB" line, as bytes
+int64_t kb_field(const std::string & line, const char * key) {
+    const size_t n = std::strlen(key);
+    if (line.compare(0, n, key) != 0) {
+        return -1;
+    }
+    return (int64_t) std::atoll(line.c_str() + n) * 1024;
+}
+
+} // namespace
+
+BufferSizeCapture::BufferSizeCapture() : prev_(t_capture) {
+    t_capture = this;
+}
+
+BufferSizeCapture::~BufferSizeCapture() {
+    t_capture = prev_;
+}
+
+void BufferSizeCapture::on_log_line(const char * text) {
+    BufferSizeCapture * capture = t_capture;
+    if (capture == nullptr) {
+        return;
+    }
+    for (const SizeLabel & label : kSizeLabels) {
+        const char * at = std::strstr(text, label.label);
+        if (at == nullptr) {
+            continue;
+        }
+        const int64_t bytes = parse_size(at + std::strlen(label.label));
+        if (bytes < 0) {
+            return;
+        }
+        int64_t & field = capture->sizes_.*label.field;
+        field = label.accumulate && field > 0 ? field + bytes : bytes;
+        return;
+    }
+}
+
+void install_whisper_log_hook() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        whisper_log_set(whisper_log_hook, nullptr);
+    });
+}
+
+int64_t ContextMemory::total() const {
+    int64_t sum = 0;
+    for (int64_t bytes : {weights, kv_self, kv_cross, compute, scratch}) {
+        if (bytes > 0) {
+            sum += bytes;
+        }
+    }
+    return sum;
+}
+
+ContextMemory context_memory(Model & model) {
+    const WhisperBufferSizes state = model.states->buffer_sizes();
+
+    ContextMemory memory;
+    memory.n_states = model.states->n_allocated();
+    memory.weights  = model.weights_bytes;
+    memory.kv_self  = all_states(state.kv_self, memory.n_states);
+    memory.kv_cross = all_states(state.kv_cross, memory.n_states);
+    memory.compute  = all_states(state.compute, memory.n_states);
+    memory.scratch  = all_states(state.kv_pad, memory.n_states);
+    return memory;
+}
+
+ProcessMemory process_memory() {
+    ProcessMemory memory;
+    std::string line;
+
+    // Summed over all mappings by the kernel (Linux 4.14+)
+    std::ifstream rollup("/proc/self/smaps_rollup");
+    while (std::getline(rollup, line)) {
+        int64_t bytes;
+        if ((bytes = kb_field(line, "Rss:")) >= 0) {
+            memory.rss = bytes;
+        } else if ((bytes = kb_field(line, "Pss:")) >= 0) {
+            memory.pss = bytes;
+        } else if ((bytes = kb_field(line, "Swap:")) >= 0) {
+            memory.swap = bytes;
+        }
+    }
+
+    std::ifstream status("/proc/self/status");
+    while (std::getline(status, line)) {
+        int64_t bytes;
+        if ((bytes = kb_field(line, "VmHWM:")) >= 0) {
+            memory.peak_rss = bytes;
+        } else if (memory.rss < 0 && (bytes = kb_field(line, "VmRSS:")) >= 0) {
+            memory.rss = bytes;
+        } else if (memory.swap < 0 && (bytes = kb_field(line, "VmSwap:")) >= 0) {
+            memory.swap = bytes;
+        }
+    }
+    return memory;
+}
+
+void reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+} // namespace memex
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+namespace memex {
+
+struct Model;
+
+// Buffer sizes whisper.cpp reported while loading a model or creating a
+// decoder state, in bytes; -1 where it reported none. whisper.cpp keeps
+// these buffers private and only logs their sizes, so they are read from its
+// log output (see BufferSizeCapture).
+struct WhisperBufferSizes {
+    int64_t weights  = -1;  // model tensors
+    int64_t kv_self  = -1;  // decoder self-attention KV cache
+    int64_t kv_cross = -1;  // cross-attention KV cache over the encoder output
+    int64_t kv_pad   = -1;  // padding scratch for the encoder's attention
+    int64_t compute  = -1;  // conv, encoder, cross and decoder graph buffers
+};
+
+// Collects the buffer sizes whisper.cpp logs on the calling thread for the
+// lifetime of the capture. Needs install_whisper_log_hook().
+class BufferSizeCapture {
+public:
+    BufferSizeCapture();
+    ~BufferSizeCapture();
+
+    BufferSizeCapture(const BufferSizeCapture &) = delete;
+    BufferSizeCapture & operator=(const BufferSizeCapture &) = delete;
+
+    const WhisperBufferSizes & sizes() const { return sizes_; }
+
+    // Parse one whisper/ggml log line into the calling thread's capture, if any
+    static void on_log_line(const char * text);
+
+private:
+    WhisperBufferSizes sizes_;
+    BufferSizeCapture * prev_;
+};
+
+// Route whisper.cpp and ggml log output through LOGI/LOGW/LOGE and feed
+// BufferSizeCapture. Safe to call more than once.
+void install_whisper_log_hook();
+
+// Native memory held by one model: its weights and every decoder state it
+// has allocated. Bytes; -1 where whisper.cpp did not report the size.
+struct ContextMemory {
+    int64_t weights = -1;
+    int64_t kv_self = -1;   // all states
+    int64_t kv_cross = -1;  // all states
+    int64_t compute = -1;   // all states
+    int64_t scratch = -1;   // all states
+    int n_states = 0;
+
+    // Sum of the known sizes
+    int64_t total() const;
+};
+
+ContextMemory context_memory(Model & model);
+
+// Process-wide memory from /proc/self, in bytes; -1 where unavailable.
+// PSS splits shared pages (e.g. a memory-mapped model file or libraries
+// shared with zygote) between the processes mapping them.
+struct ProcessMemory {
+    int64_t rss = -1;
+    int64_t pss = -1;
+    int64_t peak_rss = -1;  // VmHWM, since start or the last reset_peak_rss()
+    int64_t swap = -1;
+};
+
+ProcessMemory process_memory();
+
+// Restart peak RSS tracking from the current RSS (Linux 4.0+; the peak stays
+// cumulative where this is unsupported).
+void reset_peak_rss();
+
+} // namespace memex
@@ -0,0 +1,172 @@
+#include "model_loader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+std::mutex g_options_mutex;
+LoadOptions g_options;
+
+size_t read_mapped(void * ctx, void * output, size_t read_size) {
+    auto * reader = static_cast<MappedModelReader *>(ctx);
+    const size_t n = std::min(read_size, reader->region->size() - reader->pos);
+    memcpy(output, reader->region->data() + reader->pos, n);
+    reader->pos += n;
+    return n;
+}
+
+bool eof_mapped(void * ctx) {
+    auto * reader = static_cast<MappedModelReader *>(ctx);
+    return reader->pos >= reader->region->size();
+}
+
+void close_mapped(void * /* ctx */) {
+    // The region is owned by the caller and unmapped after init returns.
+}
+
+} // namespace
+
+MappedRegion::~MappedRegion() {
+    unmap();
+}
+
+bool MappedRegion::map(int fd, off64_t offset, size_t length, const LoadOptions & options) {
+    unmap();
+
+    const off64_t page_size = sysconf(_SC_PAGESIZE);
+    const off64_t aligned_offset = offset - (offset % page_size);
+    const size_t delta = (size_t) (offset - aligned_offset);
+
+    void * base = mmap64(nullptr, length + delta, PROT_READ, MAP_SHARED, fd, aligned_offset);
+    if (base == MAP_FAILED) {
+        LOGE("mmap failed: %s", strerror(errno));
+        return false;
+    }
+
+    base_ = base;
+    base_size_ = length + delta;
+    data_ = static_cast<const uint8_t *>(base) + delta;
+    size_ = length;
+
+    // The loader walks the file front to back exactly once: read ahead
+    // aggressively and let the kernel drop pages behind us.
+    if (madvise(base_, base_size_, MADV_WILLNEED) != 0) {
+        LOGW("madvise(MADV_WILLNEED) failed: %s", strerror(errno));
+    }
+    if (madvise(base_, base_size_, MADV_SEQUENTIAL) != 0) {
+        LOGW("madvise(MADV_SEQUENTIAL) failed: %s", strerror(errno));
+    }
+#ifdef MADV_HUGEPAGE
+    if (options.advise_hugepage && madvise(base_, base_size_, MADV_HUGEPAGE) != 0) {
+        LOGW("madvise(MADV_HUGEPAGE) not supported for this mapping: %s", strerror(errno));
+    }
+#endif
+
+    return true;
+}
+
+void MappedRegion::unmap() {
+    if (base_ != nullptr) {
+        munmap(base_, base_size_);
+    }
+    base_ = nullptr;
+    base_size_ = 0;
+    data_ = nullptr;
+    size_ = 0;
+}
+
+whisper_model_loader MappedModelReader::loader() {
+    whisper_model_loader loader = {};
+    loader.context = this;
+    loader.read = read_mapped;
+    loader.eof = eof_mapped;
+    loader.close = close_mapped;
+    return loader;
+}
+
+struct whisper_context * load_model_from_file(const std::string & path,
+                                              const struct whisper_context_params & cparams,
+                                              const LoadOptions & options) {
+    const size_t rss_before = current_rss_bytes();
+    const auto t_start = std::chrono::steady_clock::now();
+
+    struct whisper_context * ctx = nullptr;
+
+    if (options.use_mmap) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            LOGE("Failed to open model file: %s (%s)", path.c_str(), strerror(errno));
+            return nullptr;
+        }
+
+        struct stat st = {};
+        MappedRegion region;
+        if (fstat(fd, &st) == 0 && st.st_size > 0 &&
+            region.map(fd, 0, (size_t) st.st_size, options)) {
+            MappedModelReader reader;
+            reader.region = &region;
+            whisper_model_loader loader = reader.loader();
+            ctx = whisper_init_with_params_no_state(&loader, cparams);
+        }
+
+        // The mapping is only needed while the tensors are being filled.
+        region.unmap();
+        close(fd);
+    } else {
+        ctx = whisper_init_from_file_with_params_no_state(path.c_str(), cparams);
+    }
+
+    if (ctx == nullptr) {
+        return nullptr;
+    }
+
+    const auto t_load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t_start).count();
+    const size_t rss_after = current_rss_bytes();
+
+    LOGI("Model load (%s): %lld ms, RSS %.1f MB -> %.1f MB",
+         options.use_mmap ? "mmap" : "stdio", (long long) t_load_ms,
+         rss_before / (1024.0 * 1024.0), rss_after / (1024.0 * 1024.0));
+    return ctx;
+}
+
+LoadOptions get_default_load_options() {
+    std::lock_guard<std::mutex> lock(g_options_mutex);
+    return g_options;
+}
+
+void set_default_load_options(const LoadOptions & options) {
+    std::lock_guard<std::mutex> lock(g_options_mutex);
+    g_options = options;
+}
+
+size_t current_rss_bytes() {
+    FILE * f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) {
+        return 0;
+    }
+
+    long pages_total = 0;
+    long pages_resident = 0;
+    const int n = fscanf(f, "%ld %ld", &pages_total, &pages_resident);
+    fclose(f);
+
+    if (n != 2) {
+        return 0;
+    }
+    return (size_t) pages_resident * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+} // namespace memex
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include "whisper.h"
+
+namespace memex {
+
+struct LoadOptions {
+    // Map the model file instead of reading it through stdio buffers.
+    bool use_mmap = true;
+    // Ask for transparent huge pages on the mapping. Only takes effect on
+    // kernels with read-only THP for file mappings; ignored otherwise.
+    bool advise_hugepage = false;
+};
+
+// Read-only mapping of a byte range of a file. The range does not need to
+// be page aligned; the mapping is widened to the enclosing pages internally.
+class MappedRegion {
+public:
+    MappedRegion() = default;
+    ~MappedRegion();
+
+    MappedRegion(const MappedRegion &) = delete;
+    MappedRegion & operator=(const MappedRegion &) = delete;
+
+    bool map(int fd, off64_t offset, size_t length, const LoadOptions & options);
+    void unmap();
+
+    const uint8_t * data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void * base_ = nullptr;
+    size_t base_size_ = 0;
+    const uint8_t * data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// whisper_model_loader reading sequentially from a MappedRegion.
+struct MappedModelReader {
+    const MappedRegion * region = nullptr;
+    size_t pos = 0;
+
+    whisper_model_loader loader();
+};
+
+// Load a model from `path` without a default state, honouring `options`.
+// Logs load time and resident-set growth so the two paths can be compared.
+struct whisper_context * load_model_from_file(const std::string & path,
+                                              const struct whisper_context_params & cparams,
+                                              const LoadOptions & options);
+
+// Process-wide load options used by the JNI entry points.
+LoadOptions get_default_load_options();
+void set_default_load_options(const LoadOptions & options);
+
+// Current resident set size of this process in bytes, or 0 if unavailable.
+size_t current_rss_bytes();
+
+} // namespace memex
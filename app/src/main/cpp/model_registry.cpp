@@ -0,0 +1,140 @@
+#include "model_registry.h"
+
+#include <chrono>
+#include <sstream>
+#include <utility>
+#include "log.h"
+#include "memory_stats.h"
+#include "model_loader.h"
+#include "trace.h"
+
+namespace memex {
+
+Model::Model(std::string key, struct whisper_context * ctx)
+    : key(std::move(key)), ctx(ctx), states(new StatePool(ctx, StatePool::default_max_states())) {}
+
+Model::~Model() {
+    // States reference the context's weights, so they go first.
+    states.reset();
+    if (ctx != nullptr) {
+        whisper_free(ctx);
+        LOGI("Model freed: %s", key.c_str());
+    }
+}
+
+ModelRegistry & ModelRegistry::instance() {
+    static ModelRegistry registry;
+    return registry;
+}
+
+std::string ModelRegistry::make_key(const std::string & source,
+                                    const struct whisper_context_params & cparams) {
+    std::ostringstream key;
+    key << source
+        << "|gpu=" << cparams.use_gpu
+        << "|fa=" << cparams.flash_attn
+        << "|dev=" << cparams.gpu_device
+        << "|dtw=" << cparams.dtw_token_timestamps;
+    return key.str();
+}
+
+std::shared_ptr<Model> ModelRegistry::acquire(const std::string & source,
+                                              const struct whisper_context_params & cparams,
+                                              const Loader & load) {
+    const std::string key = make_key(source, cparams);
+
+    // Loading happens under the registry lock so that two callers racing on a
+    // cold model do not both pay for (and double the memory of) the load.
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = models_.find(key);
+    if (it != models_.end()) {
+        return it->second;
+    }
+
+    install_whisper_log_hook();
+
+    const auto t_start = std::chrono::steady_clock::now();
+    struct whisper_context * ctx = nullptr;
+    BufferSizeCapture capture;
+    {
+        TraceSpan span(STAGE_LOAD);
+        ctx = load();
+    }
+    if (ctx == nullptr) {
+        LOGE("Failed to load model: %s", source.c_str());
+        return nullptr;
+    }
+    const auto t_load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t_start).count();
+
+    auto model = std::make_shared<Model>(key, ctx);
+    model->weights_bytes = capture.sizes().weights;
+    models_[key] = model;
+    sources_[key] = source;
+
+    LOGI("Model loaded in %lld ms: %s (%zu cached)",
+         (long long) t_load_ms, source.c_str(), models_.size());
+    return model;
+}
+
+std::shared_ptr<Model> ModelRegistry::acquire(const std::string & path,
+                                              const struct whisper_context_params & cparams) {
+    return acquire(path, cparams, [&path, &cparams]() {
+        return load_model_from_file(path, cparams, get_default_load_options());
+    });
+}
+
+size_t ModelRegistry::evict(const std::string & source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t n_evicted = 0;
+    for (auto it = sources_.begin(); it != sources_.end(); ) {
+        if (it->second == source) {
+            models_.erase(it->first);
+            it = sources_.erase(it);
+            ++n_evicted;
+        } else {
+            ++it;
+        }
+    }
+
+    LOGI("Evicted %zu model(s) for %s", n_evicted, source.c_str());
+    return n_evicted;
+}
+
+size_t ModelRegistry::evict_unused() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t n_evicted = 0;
+    for (auto it = models_.begin(); it != models_.end(); ) {
+        if (it->second.use_count() == 1) {
+            sources_.erase(it->first);
+            it = models_.erase(it);
+            ++n_evicted;
+        } else {
+            ++it;
+        }
+    }
+
+    LOGI("Evicted %zu unused model(s), %zu still cached", n_evicted, models_.size());
+    return n_evicted;
+}
+
+size_t ModelRegistry::evict_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const size_t n_evicted = models_.size();
+    models_.clear();
+    sources_.clear();
+
+    LOGI("Evicted all %zu cached model(s)", n_evicted);
+    return n_evicted;
+}
+
+size_t ModelRegistry::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return models_.size();
+}
+
+} // namespace memex
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "state_pool.h"
+#include "whisper.h"
+
+namespace memex {
+
+// A loaded model shared by every caller that asked for the same path and
+// context params. The whisper_context is freed when the last reference goes.
+// The context is loaded without a default state; decoding always goes through
+// a state leased from `states`.
+struct Model {
+    std::string key;
+    struct whisper_context * ctx = nullptr;
+    std::unique_ptr<StatePool> states;
+
+    // Encoder time of a full 30 s window, averaged over requests that ran
+    // one; 0 until the first. Used to report what a shorter audio_ctx saved.
+    std::atomic<float> full_window_encode_ms{0.0f};
+
+    // Size of the weights as reported by whisper.cpp at load; -1 if unknown
+    int64_t weights_bytes = -1;
+
+    Model(std::string key, struct whisper_context * ctx);
+    ~Model();
+
+    Model(const Model &) = delete;
+    Model & operator=(const Model &) = delete;
+};
+
+// Process-wide cache of loaded models keyed by model path + context params.
+// Models stay resident after their last user is gone until explicitly evicted.
+class ModelRegistry {
+public:
+    using Loader = std::function<struct whisper_context *()>;
+
+    static ModelRegistry & instance();
+
+    // Return the cached model for (source, cparams) or create it with `load`.
+    // `load` must return a context created with one of the *_no_state
+    // initializers.
+    // `source` identifies where the weights come from, e.g. a file path or
+    // "asset://models/ggml-tiny.bin". Returns nullptr if loading fails.
+    std::shared_ptr<Model> acquire(const std::string & source,
+                                   const struct whisper_context_params & cparams,
+                                   const Loader & load);
+
+    // Convenience overload that loads `path` from the filesystem with the
+    // process-wide LoadOptions (mmap by default).
+    std::shared_ptr<Model> acquire(const std::string & path,
+                                   const struct whisper_context_params & cparams);
+
+    // Drop every cached model loaded from `source`. Models still referenced by
+    // a caller are freed when that caller releases them. Returns the number of
+    // registry entries removed.
+    size_t evict(const std::string & source);
+
+    // Drop cached models that no caller currently holds.
+    size_t evict_unused();
+
+    // Drop every cached model.
+    size_t evict_all();
+
+    size_t size();
+
+    static std::string make_key(const std::string & source,
+                                const struct whisper_context_params & cparams);
+
+private:
+    ModelRegistry() = default;
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Model>> models_;
+    std::unordered_map<std::string, std::string> sources_;
+};
+
+} // namespace memex
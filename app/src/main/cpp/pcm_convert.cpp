@@ -0,0 +1,113 @@
+#include "pcm_convert.h"
+
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MEMEX_PCM_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MEMEX_PCM_SSE2 1
+#endif
+
+namespace memex {
+
+void pcm_s16_to_f32(const int16_t * src, float * dst, size_t n) {
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+
+#if defined(MEMEX_PCM_NEON)
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    for (; i + 16 <= n; i += 16) {
+        const int16x8_t a = vld1q_s16(src + i);
+        const int16x8_t b = vld1q_s16(src + i + 8);
+        vst1q_f32(dst + i,      vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(a))),  vscale));
+        vst1q_f32(dst + i + 4,  vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(a))), vscale));
+        vst1q_f32(dst + i + 8,  vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(b))),  vscale));
+        vst1q_f32(dst + i + 12, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(b))), vscale));
+    }
+#elif defined(MEMEX_PCM_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        // Sign-extend int16 -> int32 by placing each sample in the high half
+        // and shifting it back down arithmetically
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(dst + i,     _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+void pcm_s16le_bytes_to_f32(const uint8_t * src, float * dst, size_t n) {
+    if ((reinterpret_cast<uintptr_t>(src) & 1) == 0) {
+        pcm_s16_to_f32(reinterpret_cast<const int16_t *>(src), dst, n);
+        return;
+    }
+
+    // Misaligned input: bounce through a small aligned block
+    int16_t block[1024];
+    for (size_t i = 0; i < n; ) {
+        const size_t n_block = n - i < 1024 ? n - i : 1024;
+        memcpy(block, src + 2 * i, n_block * sizeof(int16_t));
+        pcm_s16_to_f32(block, dst + i, n_block);
+        i += n_block;
+    }
+}
+
+void pcm_u8_to_f32(const uint8_t * src, float * dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = ((int) src[i] - 128) * (1.0f / 128.0f);
+    }
+}
+
+void pcm_s24_to_f32(const uint8_t * src, float * dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t * p = src + 3 * i;
+        // Assemble in the top 24 bits so the shift sign-extends
+        const int32_t v = (int32_t) (((uint32_t) p[0] << 8) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 24));
+        dst[i] = (v >> 8) * (1.0f / 8388608.0f);
+    }
+}
+
+void pcm_s32_to_f32(const uint8_t * src, float * dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        int32_t v;
+        memcpy(&v, src + 4 * i, sizeof(v));
+        dst[i] = (float) v * (1.0f / 2147483648.0f);
+    }
+}
+
+void pcm_f64_to_f32(const uint8_t * src, float * dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        double v;
+        memcpy(&v, src + 8 * i, sizeof(v));
+        dst[i] = (float) v;
+    }
+}
+
+void downmix_to_mono(const float * src, float * dst, size_t n_frames, int n_channels) {
+    if (n_channels <= 1) {
+        if (dst != src) {
+            memmove(dst, src, n_frames * sizeof(float));
+        }
+        return;
+    }
+
+    const float scale = 1.0f / n_channels;
+    for (size_t i = 0; i < n_frames; ++i) {
+        const float * frame = src + i * n_channels;
+        float sum = 0.0f;
+        for (int c = 0; c < n_channels; ++c) {
+            sum += frame[c];
+        }
+        dst[i] = sum * scale;
+    }
+}
+
+} // namespace memex
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace memex {
+
+// Sample-format conversion kernels. All inputs are little-endian interleaved
+// PCM; outputs are float in [-1, 1). The byte-pointer variants tolerate
+// unaligned input, as found in WAV files with odd-sized chunks. The int16
+// kernel is vectorized with NEON on ARM and SSE2 on x86; the others are
+// scalar loops the compiler can auto-vectorize.
+
+void pcm_s16_to_f32(const int16_t * src, float * dst, size_t n);
+// Same as pcm_s16_to_f32 for a raw little-endian byte stream that may not
+// be 2-byte aligned (e.g. a region of a direct ByteBuffer or a WAV chunk).
+void pcm_s16le_bytes_to_f32(const uint8_t * src, float * dst, size_t n);
+
+void pcm_u8_to_f32(const uint8_t * src, float * dst, size_t n);
+void pcm_s24_to_f32(const uint8_t * src, float * dst, size_t n);
+void pcm_s32_to_f32(const uint8_t * src, float * dst, size_t n);
+void pcm_f64_to_f32(const uint8_t * src, float * dst, size_t n);
+
+// Average `n_channels` interleaved channels of `n_frames` frames into `dst`.
+// `dst` may alias `src`.
+void downmix_to_mono(const float * src, float * dst, size_t n_frames, int n_channels);
+
+} // namespace memex
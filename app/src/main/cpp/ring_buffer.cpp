@@ -0,0 +1,105 @@
+#include "ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include "pcm_convert.h"
+
+namespace memex {
+
+namespace {
+
+size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+} // namespace
+
+PcmRingBuffer::PcmRingBuffer(size_t capacity)
+    : data_(new int16_t[round_up_pow2(std::max<size_t>(capacity, 2))]),
+      capacity_(round_up_pow2(std::max<size_t>(capacity, 2))),
+      mask_(capacity_ - 1) {}
+
+PcmRingBuffer::View PcmRingBuffer::span_at(uint64_t pos, size_t n) const {
+    View view;
+    const size_t start = (size_t) (pos & mask_);
+    view.first = data_.get() + start;
+    view.n_first = std::min(n, capacity_ - start);
+    view.second = data_.get();
+    view.n_second = n - view.n_first;
+    return view;
+}
+
+size_t PcmRingBuffer::write(const int16_t * samples, size_t n) {
+    View span = write_span(n);
+    memcpy(const_cast<int16_t *>(span.first), samples, span.n_first * sizeof(int16_t));
+    memcpy(const_cast<int16_t *>(span.second), samples + span.n_first, span.n_second * sizeof(int16_t));
+    commit(span.size());
+
+    if (span.size() < n) {
+        add_overrun(n - span.size());
+    }
+    return span.size();
+}
+
+PcmRingBuffer::View PcmRingBuffer::write_span(size_t n) {
+    const uint64_t w = write_pos_.load(std::memory_order_relaxed);
+    const uint64_t r = read_pos_.load(std::memory_order_acquire);
+    const size_t space = capacity_ - (size_t) (w - r);
+    return span_at(w, std::min(n, space));
+}
+
+void PcmRingBuffer::commit(size_t n) {
+    // Release: the samples written above become visible before the new index
+    write_pos_.store(write_pos_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+void PcmRingBuffer::add_overrun(size_t n) {
+    overruns_.fetch_add(n, std::memory_order_relaxed);
+}
+
+PcmRingBuffer::View PcmRingBuffer::peek(size_t max_samples) const {
+    const uint64_t r = read_pos_.load(std::memory_order_relaxed);
+    const uint64_t w = write_pos_.load(std::memory_order_acquire);
+    return span_at(r, std::min(max_samples, (size_t) (w - r)));
+}
+
+void PcmRingBuffer::consume(size_t n) {
+    // Release: our reads of the region finish before the producer may reuse it
+    read_pos_.store(read_pos_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+size_t PcmRingBuffer::read(int16_t * out, size_t n) {
+    View view = peek(n);
+    memcpy(out, view.first, view.n_first * sizeof(int16_t));
+    memcpy(out + view.n_first, view.second, view.n_second * sizeof(int16_t));
+    consume(view.size());
+    return view.size();
+}
+
+size_t PcmRingBuffer::read_f32(float * out, size_t n) {
+    View view = peek(n);
+    view_to_f32(view, out);
+    consume(view.size());
+    return view.size();
+}
+
+size_t PcmRingBuffer::size() const {
+    const uint64_t r = read_pos_.load(std::memory_order_acquire);
+    const uint64_t w = write_pos_.load(std::memory_order_acquire);
+    return (size_t) (w - r);
+}
+
+void PcmRingBuffer::clear() {
+    read_pos_.store(write_pos_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void view_to_f32(const PcmRingBuffer::View & view, float * out) {
+    pcm_s16_to_f32(view.first, out, view.n_first);
+    pcm_s16_to_f32(view.second, out + view.n_first, view.n_second);
+}
+
+} // namespace memex
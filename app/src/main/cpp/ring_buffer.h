@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace memex {
+
+// Lock-free single-producer / single-consumer ring of int16 PCM samples.
+//
+// The capture thread is the only writer and the transcription side the only
+// reader. Storage is allocated once up front; when the reader falls behind,
+// samples that do not fit are dropped (never blocking the capture thread) and
+// counted as overruns.
+class PcmRingBuffer {
+public:
+    // Two spans covering `size()` samples starting at the read position. The
+    // second span is non-empty only when the readable region wraps.
+    struct View {
+        const int16_t * first = nullptr;
+        size_t n_first = 0;
+        const int16_t * second = nullptr;
+        size_t n_second = 0;
+
+        size_t size() const { return n_first + n_second; }
+    };
+
+    // Capacity is rounded up to a power of two.
+    explicit PcmRingBuffer(size_t capacity);
+
+    PcmRingBuffer(const PcmRingBuffer &) = delete;
+    PcmRingBuffer & operator=(const PcmRingBuffer &) = delete;
+
+    // Producer side.
+
+    // Copy up to `n` samples in; returns how many were stored.
+    size_t write(const int16_t * samples, size_t n);
+
+    // Writable region for filling in place (e.g. from GetShortArrayRegion),
+    // followed by commit(). Same span layout as View.
+    View write_span(size_t n);
+    void commit(size_t n);
+
+    // Count `n` samples the producer had to drop.
+    void add_overrun(size_t n);
+
+    // Consumer side.
+
+    // Zero-copy view of up to `max_samples` readable samples. Valid until the
+    // consumer calls consume(); the producer never touches this region.
+    View peek(size_t max_samples) const;
+    void consume(size_t n);
+
+    // Copy out up to `n` samples and consume them.
+    size_t read(int16_t * out, size_t n);
+
+    // Convert up to `n` samples to float and consume them.
+    size_t read_f32(float * out, size_t n);
+
+    // Either side.
+    size_t capacity() const { return capacity_; }
+    size_t size() const;
+    size_t free_space() const { return capacity_ - size(); }
+    uint64_t total_written() const { return write_pos_.load(std::memory_order_acquire); }
+    uint64_t overrun_samples() const { return overruns_.load(std::memory_order_relaxed); }
+
+    // Drop everything readable. Consumer side only.
+    void clear();
+
+private:
+    View span_at(uint64_t pos, size_t n) const;
+
+    std::unique_ptr<int16_t[]> data_;
+    size_t capacity_;
+    size_t mask_;
+
+    // Indices grow monotonically and are masked on access. Kept on separate
+    // cache lines so producer and consumer do not false-share.
+    alignas(64) std::atomic<uint64_t> write_pos_{0};
+    alignas(64) std::atomic<uint64_t> read_pos_{0};
+    alignas(64) std::atomic<uint64_t> overruns_{0};
+};
+
+// Convert a (possibly wrapped) view to contiguous float samples.
+void view_to_f32(const PcmRingBuffer::View & view, float * out);
+
+} // namespace memex
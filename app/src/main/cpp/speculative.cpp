@@ -0,0 +1,217 @@
+#include "speculative.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include "cpu_topology.h"
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// One model's decoder with its KV cache position. Positions at or past
+// n_past are dropped by the next decode, which is how rejected drafts are
+// rolled back.
+struct Decoder {
+    struct whisper_context * ctx;
+    struct whisper_state * state;
+    int n_threads;
+    int * n_passes;
+    int n_past = 0;
+    int n_last = 0;  // tokens in the last batch; its final row holds the logits
+
+    bool eval(const whisper_token * tokens, int n_tokens) {
+        ++*n_passes;
+        if (whisper_decode_with_state(ctx, state, tokens, n_tokens, n_past, n_threads) != 0) {
+            LOGE("Speculative decode pass failed at position %d", n_past);
+            return false;
+        }
+        n_past += n_tokens;
+        n_last = n_tokens;
+        return true;
+    }
+
+    bool eval(whisper_token token) { return eval(&token, 1); }
+
+    // Greedy choice over text tokens and end-of-text; timestamps and other
+    // specials are never sampled without timestamps. Fills `prob` if set.
+    whisper_token best(TokenProb * prob = nullptr) const {
+        const whisper_token eot = whisper_token_eot(ctx);
+        const float * logits = whisper_get_logits_from_state(state) + (size_t) (n_last - 1) * whisper_n_vocab(ctx);
+
+        whisper_token best = 0;
+        for (whisper_token id = 1; id <= eot; ++id) {
+            if (logits[id] > logits[best]) {
+                best = id;
+            }
+        }
+        if (prob != nullptr) {
+            double sum = 0.0;
+            for (whisper_token id = 0; id <= eot; ++id) {
+                sum += std::exp((double) (logits[id] - logits[best]));
+            }
+            prob->id = best;
+            prob->plog = (float) -std::log(sum);
+            prob->p = std::exp(prob->plog);
+        }
+        return best;
+    }
+};
+
+bool prepare(const Model & model, struct whisper_state * state, const float * samples, int n_samples,
+             int n_threads) {
+    if (whisper_pcm_to_mel_with_state(model.ctx, state, samples, n_samples, n_threads) != 0) {
+        LOGE("Failed to compute mel for %s", model.key.c_str());
+        return false;
+    }
+    if (whisper_encode_with_state(model.ctx, state, 0, n_threads) != 0) {
+        LOGE("Failed to encode with %s", model.key.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<whisper_token> prompt_for(struct whisper_context * ctx, const std::string & language) {
+    std::vector<whisper_token> prompt = {whisper_token_sot(ctx)};
+    if (whisper_is_multilingual(ctx)) {
+        const int lang_id = whisper_lang_id(language.c_str());
+        prompt.push_back(whisper_token_lang(ctx, lang_id >= 0 ? lang_id : 0));
+        prompt.push_back(whisper_token_transcribe(ctx));
+    }
+    prompt.push_back(whisper_token_not(ctx));
+    return prompt;
+}
+
+} // namespace
+
+SpeculativeResult transcribe_speculative(const Model & target, struct whisper_state * target_state,
+                                         const Model & draft, struct whisper_state * draft_state,
+                                         const float * samples, int n_samples,
+                                         const SpeculativeParams & params,
+                                         const CancelToken * cancel) {
+    SpeculativeResult result;
+    SpeculativeStats & stats = result.stats;
+
+    if (whisper_n_vocab(target.ctx) != whisper_n_vocab(draft.ctx)
+            || whisper_model_n_mels(target.ctx) != whisper_model_n_mels(draft.ctx)
+            || whisper_is_multilingual(target.ctx) != whisper_is_multilingual(draft.ctx)) {
+        LOGE("Draft model %s does not share the vocabulary of %s", draft.key.c_str(), target.key.c_str());
+        return result;
+    }
+    if (n_samples > 30 * WHISPER_SAMPLE_RATE) {
+        LOGE("Speculative decoding takes clips of at most 30 s, got %.1f s",
+             (double) n_samples / WHISPER_SAMPLE_RATE);
+        return result;
+    }
+
+    const int n_threads = resolve_thread_count(params.n_threads);
+    const auto t_encode = std::chrono::steady_clock::now();
+    if (!prepare(target, target_state, samples, n_samples, n_threads)
+            || !prepare(draft, draft_state, samples, n_samples, n_threads)) {
+        return result;
+    }
+    stats.encode_ms = elapsed_ms(t_encode);
+
+    const auto t_decode = std::chrono::steady_clock::now();
+    Decoder target_dec{target.ctx, target_state, n_threads, &stats.n_target_passes};
+    Decoder draft_dec{draft.ctx, draft_state, n_threads, &stats.n_draft_passes};
+
+    const std::vector<whisper_token> prompt = prompt_for(target.ctx, params.language);
+    if (!target_dec.eval(prompt.data(), (int) prompt.size())
+            || !draft_dec.eval(prompt.data(), (int) prompt.size())) {
+        return result;
+    }
+
+    // Both KV caches hold the prompt plus every emitted token, and `next` is
+    // the target's choice for the following position
+    const whisper_token eot = whisper_token_eot(target.ctx);
+    const int max_tokens = whisper_n_text_ctx(target.ctx) / 2 - (int) prompt.size();
+    const int n_draft = std::min(std::max(1, params.n_draft), kMaxDraftTokens);
+    std::vector<TokenProb> & tokens = result.segment.tokens;
+    std::vector<whisper_token> proposal;
+    TokenProb next;
+    target_dec.best(&next);
+
+    while (next.id != eot && (int) tokens.size() < max_tokens) {
+        if (cancel != nullptr && cancel->should_abort()) {
+            LOGI("Speculative decode cancelled after %zu tokens", tokens.size());
+            return result;
+        }
+        ++stats.n_rounds;
+
+        // Draft: extend the draft's own cache with up to n_draft proposals
+        const int draft_base = draft_dec.n_past;
+        proposal.clear();
+        while ((int) proposal.size() < n_draft && (int) (tokens.size() + proposal.size()) < max_tokens) {
+            const whisper_token token = draft_dec.best();
+            proposal.push_back(token);
+            if (token == eot) {
+                break;
+            }
+            if (!draft_dec.eval(token)) {
+                return result;
+            }
+        }
+        stats.n_drafted += (int) proposal.size();
+
+        // Verify: the target's choice is always emitted; the round ends at
+        // the first proposal it disagrees with
+        size_t n_matched = 0;
+        while (n_matched < proposal.size() && next.id == proposal[n_matched]) {
+            ++n_matched;
+            if (next.id == eot) {
+                break;
+            }
+            tokens.push_back(next);
+            if (!target_dec.eval(next.id)) {
+                return result;
+            }
+            target_dec.best(&next);
+        }
+        stats.n_accepted += (int) n_matched;
+
+        if (n_matched == proposal.size() && draft_dec.n_past == draft_base + (int) n_matched) {
+            continue;  // the draft cache already holds every accepted token
+        }
+        if (next.id == eot) {
+            break;
+        }
+
+        // Roll the draft back to the accepted prefix and feed it the
+        // target's correction
+        draft_dec.n_past = draft_base + (int) n_matched;
+        tokens.push_back(next);
+        if (!target_dec.eval(next.id) || !draft_dec.eval(next.id)) {
+            return result;
+        }
+        target_dec.best(&next);
+    }
+
+    stats.decode_ms = elapsed_ms(t_decode);
+    stats.n_tokens = (int) tokens.size();
+
+    TranscriptSegment & seg = result.segment;
+    seg.t1_ms = (int64_t) n_samples * 1000 / WHISPER_SAMPLE_RATE;
+    double sum_logprob = 0.0;
+    for (const TokenProb & token : tokens) {
+        seg.text += whisper_token_to_str(target.ctx, token.id);
+        sum_logprob += token.plog;
+    }
+    seg.avg_logprob = tokens.empty() ? 0.0f : (float) (sum_logprob / tokens.size());
+
+    LOGI("Speculative decode: %d tokens in %d rounds, %d/%d drafts accepted (%.0f%%), "
+         "%d target passes (%d if batched), encode %.0f ms, decode %.0f ms",
+         stats.n_tokens, stats.n_rounds, stats.n_accepted, stats.n_drafted, 100.0 * stats.acceptance_rate(),
+         stats.n_target_passes, stats.batched_target_passes(), stats.encode_ms, stats.decode_ms);
+
+    result.ok = true;
+    return result;
+}
+
+} // namespace memex
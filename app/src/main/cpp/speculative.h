@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "cancel.h"
+#include "model_registry.h"
+#include "transcript.h"
+#include "whisper.h"
+
+namespace memex {
+
+// Longest draft per round; beyond this nearly every proposal is rejected
+constexpr int kMaxDraftTokens = 16;
+
+struct SpeculativeParams {
+    int n_draft = 4;              // tokens proposed per round, clamped to 1..kMaxDraftTokens
+    int n_threads = 0;            // 0 = one per performance core
+    std::string language = "en";  // for multilingual models
+};
+
+struct SpeculativeStats {
+    int n_tokens = 0;             // text tokens emitted
+    int n_rounds = 0;             // draft/verify rounds
+    int n_drafted = 0;            // tokens proposed by the draft model
+    int n_accepted = 0;           // proposals matching the target's choice
+    int n_target_passes = 0;      // whisper_decode calls on the target
+    int n_draft_passes = 0;       // whisper_decode calls on the draft
+    double encode_ms = 0.0;       // mel + encoder, both models
+    double decode_ms = 0.0;
+
+    double acceptance_rate() const {
+        return n_drafted > 0 ? (double) n_accepted / n_drafted : 0.0;
+    }
+
+    // Target passes a verifier that scores a whole draft in one batched
+    // pass would need: one per round plus the prompt. Comparing this with
+    // the plain greedy cost (n_tokens + 1) shows what batching would save.
+    int batched_target_passes() const { return n_rounds + 1; }
+};
+
+struct SpeculativeResult {
+    bool ok = false;
+    TranscriptSegment segment;    // the whole clip, without timestamps
+    SpeculativeStats stats;
+};
+
+// Greedy transcription of one clip (at most 30 s) with `target`, drafting
+// with the smaller `draft` model conditioned on its own encoder output. The
+// draft proposes up to n_draft tokens per round; the target accepts the
+// matching prefix and supplies the first token that differs, so the text is
+// exactly what greedy decoding with the target alone produces.
+//
+// whisper.cpp's public decode API only returns logits for the last token of
+// a batch, so the target scores drafted tokens one pass each. The acceptance
+// statistics show what a batched verifier would save (see
+// SpeculativeStats::batched_target_passes).
+//
+// Both models must share the vocabulary and mel layout (tiny, base, small,
+// medium and large-v2 do; large-v3 does not). `cancel` (may be null) is
+// polled between passes.
+SpeculativeResult transcribe_speculative(const Model & target, struct whisper_state * target_state,
+                                         const Model & draft, struct whisper_state * draft_state,
+                                         const float * samples, int n_samples,
+                                         const SpeculativeParams & params,
+                                         const CancelToken * cancel);
+
+} // namespace memex
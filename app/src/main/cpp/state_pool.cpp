@@ -0,0 +1,138 @@
+#include "state_pool.h"
+
+#include <algorithm>
+#include <thread>
+#include "log.h"
+
+namespace memex {
+
+StatePool::StatePool(struct whisper_context * ctx, int max_states)
+    : ctx_(ctx), max_states_(std::max(1, max_states)) {}
+
+StatePool::~StatePool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (n_allocated_ != (int) idle_.size()) {
+        LOGE("State pool destroyed with %d state(s) still leased",
+             n_allocated_ - (int) idle_.size());
+    }
+    for (struct whisper_state * state : idle_) {
+        whisper_free_state(state);
+    }
+    idle_.clear();
+}
+
+int StatePool::default_max_states() {
+    const int n_cpus = (int) std::thread::hardware_concurrency();
+    return std::max(1, std::min(4, n_cpus / 4));
+}
+
+struct whisper_state * StatePool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return acquire_locked(lock, true);
+}
+
+struct whisper_state * StatePool::try_acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return acquire_locked(lock, false);
+}
+
+struct whisper_state * StatePool::acquire_locked(std::unique_lock<std::mutex> & lock, bool wait) {
+    for (;;) {
+        if (!idle_.empty()) {
+            struct whisper_state * state = idle_.back();
+            idle_.pop_back();
+            return state;
+        }
+
+        if (n_allocated_ < max_states_) {
+            // Allocate outside the lock: whisper_init_state sizes the KV cache
+            // and compute buffers, which takes a while.
+            ++n_allocated_;
+            lock.unlock();
+            BufferSizeCapture capture;
+            struct whisper_state * state = whisper_init_state(ctx_);
+            lock.lock();
+
+            if (state == nullptr) {
+                --n_allocated_;
+                cv_.notify_one();
+                LOGE("Failed to allocate decoder state");
+                return nullptr;
+            }
+
+            if (capture.sizes().kv_self >= 0) {
+                buffer_sizes_ = capture.sizes();
+            }
+            LOGI("Allocated decoder state %d/%d", n_allocated_, max_states_);
+            return state;
+        }
+
+        if (!wait) {
+            return nullptr;
+        }
+        cv_.wait(lock);
+    }
+}
+
+void StatePool::release(struct whisper_state * state) {
+    if (state == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (n_allocated_ > max_states_) {
+            --n_allocated_;
+            whisper_free_state(state);
+        } else {
+            idle_.push_back(state);
+        }
+    }
+    cv_.notify_one();
+}
+
+void StatePool::set_max_states(int max_states) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_states_ = std::max(1, max_states);
+        while (n_allocated_ > max_states_ && !idle_.empty()) {
+            whisper_free_state(idle_.back());
+            idle_.pop_back();
+            --n_allocated_;
+        }
+    }
+    cv_.notify_all();
+}
+
+int StatePool::max_states() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_states_;
+}
+
+int StatePool::n_allocated() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return n_allocated_;
+}
+
+int StatePool::n_idle() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int) idle_.size();
+}
+
+int StatePool::trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int n_freed = (int) idle_.size();
+    for (struct whisper_state * state : idle_) {
+        whisper_free_state(state);
+    }
+    idle_.clear();
+    n_allocated_ -= n_freed;
+    return n_freed;
+}
+
+WhisperBufferSizes StatePool::buffer_sizes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffer_sizes_;
+}
+
+} // namespace memex
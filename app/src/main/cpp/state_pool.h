@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "memory_stats.h"
+#include "whisper.h"
+
+namespace memex {
+
+// Bounded pool of whisper_state objects for one set of model weights. Each
+// state owns its own KV cache, mel buffer and results, so requests holding
+// different states can run whisper_full_with_state concurrently against the
+// same whisper_context.
+class StatePool {
+public:
+    StatePool(struct whisper_context * ctx, int max_states);
+    ~StatePool();
+
+    StatePool(const StatePool &) = delete;
+    StatePool & operator=(const StatePool &) = delete;
+
+    // Take an idle state, creating one if the pool is below capacity, or wait
+    // until another request returns one. Returns nullptr if allocation fails.
+    struct whisper_state * acquire();
+
+    // Like acquire() but never waits; returns nullptr when the pool is busy.
+    struct whisper_state * try_acquire();
+
+    void release(struct whisper_state * state);
+
+    // Change the capacity. Shrinking frees idle states immediately and busy
+    // ones as they are released.
+    void set_max_states(int max_states);
+
+    int max_states();
+    int n_allocated();
+    int n_idle();
+
+    // Free idle states (e.g. under memory pressure). Returns how many were freed.
+    int trim();
+
+    // Buffer sizes of one state as reported when the first was allocated;
+    // every state of a model has the same layout.
+    WhisperBufferSizes buffer_sizes();
+
+    // Default capacity: enough concurrent decoders to keep the big cores busy
+    // with a few threads each, without allocating a KV cache per core.
+    static int default_max_states();
+
+private:
+    struct whisper_state * acquire_locked(std::unique_lock<std::mutex> & lock, bool wait);
+
+    struct whisper_context * ctx_;
+    int max_states_;
+    int n_allocated_ = 0;
+    std::vector<struct whisper_state *> idle_;
+    WhisperBufferSizes buffer_sizes_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+// RAII lease on a pooled state; returns it to the pool on destruction.
+class StateLease {
+public:
+    StateLease() = default;
+    StateLease(StatePool * pool, struct whisper_state * state) : pool_(pool), state_(state) {}
+    ~StateLease() { reset(); }
+
+    StateLease(StateLease && other) noexcept : pool_(other.pool_), state_(other.state_) {
+        other.pool_ = nullptr;
+        other.state_ = nullptr;
+    }
+    StateLease & operator=(StateLease && other) noexcept {
+        if (this != &other) {
+            reset();
+            pool_ = other.pool_;
+            state_ = other.state_;
+            other.pool_ = nullptr;
+            other.state_ = nullptr;
+        }
+        return *this;
+    }
+
+    StateLease(const StateLease &) = delete;
+    StateLease & operator=(const StateLease &) = delete;
+
+    struct whisper_state * get() const { return state_; }
+    explicit operator bool() const { return state_ != nullptr; }
+
+    void reset() {
+        if (pool_ != nullptr && state_ != nullptr) {
+            pool_->release(state_);
+        }
+        pool_ = nullptr;
+        state_ = nullptr;
+    }
+
+private:
+    StatePool * pool_ = nullptr;
+    struct whisper_state * state_ = nullptr;
+};
+
+} // namespace memex
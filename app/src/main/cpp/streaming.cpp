@@ -0,0 +1,194 @@
+#include "streaming.h"
+
+#include <algorithm>
+#include "compute_pool.h"
+#include "cpu_topology.h"
+#include "decode_profile.h"
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+constexpr int kSampleRate = WHISPER_SAMPLE_RATE;
+
+} // namespace
+
+StreamingSession::StreamingSession(std::shared_ptr<Model> model, const StreamParams & params,
+                                   std::shared_ptr<PcmRingBuffer> external_ring)
+    : model_(std::move(model)), params_(params), owns_input_(external_ring == nullptr), vad_(params.vad) {
+    params_.keep_ms   = std::min(params_.keep_ms, params_.step_ms);
+    params_.length_ms = std::max(params_.length_ms, params_.step_ms);
+
+    n_samples_step_ = (int) (1e-3 * params_.step_ms   * kSampleRate);
+    n_samples_len_  = (int) (1e-3 * params_.length_ms * kSampleRate);
+    n_samples_keep_ = (int) (1e-3 * params_.keep_ms   * kSampleRate);
+    n_new_line_     = std::max(1, params_.length_ms / params_.step_ms - 1);
+
+    if (external_ring != nullptr) {
+        input_ = std::move(external_ring);
+    } else {
+        // Room for a couple of windows so a slow decode does not drop audio
+        input_ = std::make_shared<PcmRingBuffer>((size_t) (2 * n_samples_len_ + n_samples_step_));
+    }
+
+    // A session keeps one decoder state for its lifetime so the KV cache and
+    // buffers are not reallocated per step
+    lease_ = StateLease(model_->states.get(), model_->states->acquire());
+    if (!lease_) {
+        LOGE("No decoder state available for streaming session");
+    }
+
+    LOGI("Streaming session: step %d ms, length %d ms, keep %d ms, commit every %d steps",
+         params_.step_ms, params_.length_ms, params_.keep_ms, n_new_line_);
+}
+
+size_t StreamingSession::push(const int16_t * samples, size_t n) {
+    if (!owns_input_) {
+        LOGE("push() on a streaming session that reads a capture ring");
+        return 0;
+    }
+    return input_->write(samples, n);
+}
+
+StreamingSession::PollResult StreamingSession::poll() {
+    if (!lease_) {
+        return POLL_ERROR;
+    }
+    if (input_->size() < (size_t) n_samples_step_) {
+        return POLL_IDLE;
+    }
+    return decode_window(false);
+}
+
+StreamingSession::PollResult StreamingSession::finish() {
+    if (!lease_) {
+        return POLL_ERROR;
+    }
+    if (input_->size() == 0 && pcmf32_old_.empty()) {
+        std::lock_guard<std::mutex> lock(text_mutex_);
+        stable_ += provisional_;
+        provisional_.clear();
+        return POLL_COMMITTED;
+    }
+    return decode_window(true);
+}
+
+StreamingSession::PollResult StreamingSession::decode_window(bool force_commit) {
+    // Drain everything that arrived since the last step
+    PcmRingBuffer::View view = input_->peek(input_->size());
+    pcmf32_new_.resize(view.size());
+    view_to_f32(view, pcmf32_new_.data());
+    input_->consume(view.size());
+
+    const int n_samples_new = (int) pcmf32_new_.size();
+
+    if (params_.use_vad && !force_commit) {
+        vad_decisions_.clear();
+        vad_.process(pcmf32_new_.data(), pcmf32_new_.size(), vad_decisions_);
+        const bool any_speech = std::find(vad_decisions_.begin(), vad_decisions_.end(), 1) != vad_decisions_.end();
+        if (!any_speech) {
+            return handle_silence();
+        }
+    }
+
+    // Take up to `length` of audio: the tail of the previous window plus the new samples
+    const int n_samples_take = std::min((int) pcmf32_old_.size(),
+                                        std::max(0, n_samples_keep_ + n_samples_len_ - n_samples_new));
+
+    window_.resize(n_samples_take + n_samples_new);
+    std::copy(pcmf32_old_.end() - n_samples_take, pcmf32_old_.end(), window_.begin());
+    std::copy(pcmf32_new_.begin(), pcmf32_new_.end(), window_.begin() + n_samples_take);
+
+    whisper_full_params wparams = full_params_for(PROFILE_STREAMING, params_.n_threads);
+    wparams.audio_ctx        = params_.audio_ctx;
+    wparams.prompt_tokens    = params_.carry_prompt && !prompt_tokens_.empty() ? prompt_tokens_.data() : nullptr;
+    wparams.prompt_n_tokens  = params_.carry_prompt ? (int) prompt_tokens_.size() : 0;
+
+    struct whisper_state * state = lease_.get();
+    int status = -1;
+    ComputePool::instance().run([&] {
+        ScopedCorePinning pinning;
+        status = whisper_full_with_state(model_->ctx, state, wparams, window_.data(), (int) window_.size());
+    });
+    if (status != 0) {
+        LOGE("Streaming decode failed");
+        return POLL_ERROR;
+    }
+
+    std::string text;
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; ++i) {
+        text += whisper_full_get_segment_text_from_state(state, i);
+    }
+
+    ++n_iter_;
+    const bool commit = force_commit || (n_iter_ % n_new_line_) == 0;
+
+    if (commit) {
+        // Keep a little audio so a word straddling the boundary is not lost,
+        // and use what we just committed as the prompt for the next window
+        const int n_keep = std::min(n_samples_keep_, (int) window_.size());
+        pcmf32_old_.assign(window_.end() - n_keep, window_.end());
+
+        update_prompt();
+    } else {
+        pcmf32_old_.swap(window_);
+    }
+
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    if (commit) {
+        stable_ += text;
+        provisional_.clear();
+        return POLL_COMMITTED;
+    }
+    provisional_ = text;
+    return POLL_PROVISIONAL;
+}
+
+void StreamingSession::update_prompt() {
+    prompt_tokens_.clear();
+    if (!params_.carry_prompt) {
+        return;
+    }
+
+    struct whisper_state * state = lease_.get();
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; ++i) {
+        const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+        for (int j = 0; j < n_tokens; ++j) {
+            prompt_tokens_.push_back(whisper_full_get_token_id_from_state(state, i, j));
+        }
+    }
+}
+
+StreamingSession::PollResult StreamingSession::handle_silence() {
+    // Only keep the tail of the silence as lead-in for the next utterance
+    const int n_keep = std::min(n_samples_keep_, (int) pcmf32_new_.size());
+    pcmf32_old_.assign(pcmf32_new_.end() - n_keep, pcmf32_new_.end());
+
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    if (provisional_.empty()) {
+        return POLL_IDLE;
+    }
+
+    // A pause ends the utterance: commit what we have without re-decoding.
+    // The state still holds the last window's tokens for the prompt.
+    update_prompt();
+    n_iter_ = 0;
+    stable_ += provisional_;
+    provisional_.clear();
+    return POLL_COMMITTED;
+}
+
+std::string StreamingSession::stable_text() {
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    return stable_;
+}
+
+std::string StreamingSession::provisional_text() {
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    return provisional_;
+}
+
+} // namespace memex
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "model_registry.h"
+#include "ring_buffer.h"
+#include "state_pool.h"
+#include "vad.h"
+#include "whisper.h"
+
+namespace memex {
+
+struct StreamParams {
+    int step_ms   = 500;   // run inference every time this much new audio arrives
+    int length_ms = 5000;  // sliding window length
+    int keep_ms   = 200;   // audio carried over from the previous window at a commit
+    int n_threads = 0;     // 0 = one per performance core
+    int audio_ctx = 0;     // encoder context override, 0 = full 30 s window
+    bool carry_prompt = true;  // condition each window on the last committed text
+    bool use_vad = false;      // skip silent steps and commit at pauses
+    VadParams vad;
+};
+
+// Incremental transcription over a sliding window, modelled on whisper.cpp's
+// stream example. Audio is pushed by the capture side into a SPSC ring and
+// decoded on poll(); every window produces provisional text, and once per
+// window length the current text is committed as stable and the window
+// restarts from the last `keep_ms` of audio. With `use_vad`, steps with no
+// speech are not decoded at all and a pause commits the pending text early.
+class StreamingSession {
+public:
+    enum PollResult {
+        POLL_IDLE        = 0,  // not enough new audio yet
+        POLL_PROVISIONAL = 1,  // provisional text updated
+        POLL_COMMITTED   = 2,  // provisional text was committed to stable
+        POLL_ERROR       = -1,
+    };
+
+    // Reads from `external_ring` if given, otherwise from an internal ring
+    // filled by push(). The session becomes the external ring's consumer and
+    // keeps it alive; its capture thread stays the only producer, so push()
+    // is refused.
+    StreamingSession(std::shared_ptr<Model> model, const StreamParams & params,
+                     std::shared_ptr<PcmRingBuffer> external_ring = nullptr);
+
+    StreamingSession(const StreamingSession &) = delete;
+    StreamingSession & operator=(const StreamingSession &) = delete;
+
+    bool ok() const { return (bool) lease_; }
+
+    // Producer side: append 16 kHz mono int16 samples. Returns how many fit,
+    // 0 when reading an external ring.
+    size_t push(const int16_t * samples, size_t n);
+    PcmRingBuffer & input() { return *input_; }
+
+    // Whether the input ring is the session's own, filled by push().
+    bool owns_input() const { return owns_input_; }
+
+    // Consumer side: decode if at least one step of new audio is available.
+    PollResult poll();
+
+    // Decode whatever audio is left and commit it.
+    PollResult finish();
+
+    std::string stable_text();
+    std::string provisional_text();
+
+    const StreamParams & params() const { return params_; }
+
+private:
+    PollResult decode_window(bool force_commit);
+    PollResult handle_silence();
+
+    // Use the tokens of the last decode as the prompt for the next window
+    void update_prompt();
+
+    std::shared_ptr<Model> model_;
+    StreamParams params_;
+    StateLease lease_;
+
+    std::shared_ptr<PcmRingBuffer> input_;
+    bool owns_input_;
+
+    int n_samples_step_;
+    int n_samples_len_;
+    int n_samples_keep_;
+    int n_new_line_;
+    int n_iter_ = 0;
+
+    std::vector<float> pcmf32_new_;
+    std::vector<float> pcmf32_old_;
+    std::vector<float> window_;
+    std::vector<whisper_token> prompt_tokens_;
+
+    VoiceActivityDetector vad_;
+    std::vector<uint8_t> vad_decisions_;
+
+    std::mutex text_mutex_;
+    std::string stable_;
+    std::string provisional_;
+};
+
+} // namespace memex
@@ -0,0 +1,500 @@
+// memex-bench: end-to-end native transcription benchmark. Runs a fixed corpus
+// of command and dictation clips through memex_core, the code behind
+// memexagent_native, for every model and thread count given, and writes the
+// results as JSON for diffing between builds.
+//
+//   memex-bench --corpus DIR -m ggml-tiny.bin -m ggml-base.bin -t 2,4 -o out.json
+//
+// The corpus is DIR/command/*.wav, decoded with the command profile, and
+// DIR/dictation/*.wav, decoded with the dictation profile, in file name order.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "compute_pool.h"
+#include "cpu_backend.h"
+#include "cpu_topology.h"
+#include "decode_profile.h"
+#include "log.h"
+#include "memory_stats.h"
+#include "transcriber.h"
+#include "wav_reader.h"
+
+namespace {
+
+struct BenchOptions {
+    std::string corpus;
+    std::vector<std::string> models;
+    std::vector<int> threads;
+    int warmup = 1;
+    int repeat = 3;
+    std::string output;
+    bool verbose = false;
+};
+
+struct Clip {
+    std::string name;      // path relative to the corpus
+    std::string category;  // "command" or "dictation"
+    int profile = memex::PROFILE_DEFAULT;
+    std::vector<float> samples;
+
+    double audio_ms() const { return samples.size() * 1000.0 / WHISPER_SAMPLE_RATE; }
+};
+
+// One timed request
+struct Sample {
+    double latency_ms = 0.0;
+    double mel_ms = 0.0;
+    double encode_ms = 0.0;
+    double decode_ms = 0.0;
+    double audio_ms = 0.0;
+};
+
+struct ClipResult {
+    const Clip * clip = nullptr;
+    std::string text;
+    std::vector<Sample> samples;
+};
+
+struct RunResult {
+    std::string model;
+    int n_threads = 0;
+    double load_ms = 0.0;
+    long peak_rss_kb = -1;
+    memex::ContextMemory context_memory;
+    memex::ProcessMemory process_memory;
+    bool ok = false;
+    std::vector<ClipResult> clips;
+};
+
+const char * const kCategories[] = {"command", "dictation"};
+
+void print_usage(const char * argv0) {
+    std::fprintf(stderr,
+        "usage: %s --corpus DIR -m MODEL [-m MODEL...] [options]\n"
+        "\n"
+        "  --corpus DIR           clips in DIR/command/*.wav and DIR/dictation/*.wav\n"
+        "  -m, --model PATH       model to benchmark; repeat for several\n"
+        "  -t, --threads LIST     comma-separated thread counts (default 0: one per performance core)\n"
+        "      --warmup N         untimed passes over the corpus per run (default 1)\n"
+        "      --repeat N         timed passes over the corpus per run (default 3)\n"
+        "  -o, --output FILE      write JSON to FILE instead of stdout\n"
+        "  -v, --verbose          log native info messages\n",
+        argv0);
+}
+
+bool parse_args(int argc, char ** argv, BenchOptions & opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char * v = i + 1 < argc ? argv[i + 1] : nullptr;
+        const bool takes_value = arg == "--corpus" || arg == "-m" || arg == "--model" || arg == "-t"
+            || arg == "--threads" || arg == "--warmup" || arg == "--repeat" || arg == "-o" || arg == "--output";
+        if (takes_value) {
+            if (v == nullptr) {
+                return false;
+            }
+            ++i;
+        }
+
+        if (arg == "--corpus") {
+            opts.corpus = v;
+        } else if (arg == "-m" || arg == "--model") {
+            opts.models.push_back(v);
+        } else if (arg == "-t" || arg == "--threads") {
+            std::stringstream list(v);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                opts.threads.push_back(std::atoi(item.c_str()));
+            }
+        } else if (arg == "--warmup") {
+            opts.warmup = std::max(0, std::atoi(v));
+        } else if (arg == "--repeat") {
+            opts.repeat = std::max(1, std::atoi(v));
+        } else if (arg == "-o" || arg == "--output") {
+            opts.output = v;
+        } else if (arg == "-v" || arg == "--verbose") {
+            opts.verbose = true;
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (opts.threads.empty()) {
+        opts.threads.push_back(0);
+    }
+    return !opts.corpus.empty() && !opts.models.empty();
+}
+
+std::vector<std::string> wav_files(const std::string & dir) {
+    std::vector<std::string> names;
+    DIR * d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return names;
+    }
+    while (struct dirent * entry = readdir(d)) {
+        const std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".wav") == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+bool load_corpus(const std::string & root, std::vector<Clip> & clips) {
+    for (const char * category : kCategories) {
+        const std::string dir = root + "/" + category;
+        for (const std::string & name : wav_files(dir)) {
+            Clip clip;
+            clip.name = std::string(category) + "/" + name;
+            clip.category = category;
+            clip.profile = std::strcmp(category, "command") == 0 ? memex::PROFILE_COMMAND : memex::PROFILE_DICTATION;
+            clip.samples = memex::read_wav(dir + "/" + name);
+            if (clip.samples.empty()) {
+                std::fprintf(stderr, "failed to read %s\n", clip.name.c_str());
+                return false;
+            }
+            clips.push_back(std::move(clip));
+        }
+    }
+    return !clips.empty();
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+RunResult run_config(const std::string & model_path, int n_threads, const std::vector<Clip> & corpus,
+                     const BenchOptions & opts) {
+    RunResult run;
+    run.model = model_path;
+    run.n_threads = memex::resolve_thread_count(n_threads);
+
+    // Every run loads the model from scratch
+    memex::ModelRegistry::instance().evict_unused();
+    memex::reset_peak_rss();
+
+    const auto t_load = std::chrono::steady_clock::now();
+    std::unique_ptr<memex::Transcriber> transcriber = memex::make_transcriber(memex::acquire_model_file(model_path));
+    run.load_ms = elapsed_ms(t_load);
+    if (!transcriber) {
+        std::fprintf(stderr, "failed to load model %s\n", model_path.c_str());
+        return run;
+    }
+
+    for (const Clip & clip : corpus) {
+        ClipResult result;
+        result.clip = &clip;
+        run.clips.push_back(std::move(result));
+    }
+
+    for (int pass = 0; pass < opts.warmup + opts.repeat; ++pass) {
+        const bool timed = pass >= opts.warmup;
+        for (ClipResult & clip_result : run.clips) {
+            const Clip & clip = *clip_result.clip;
+            const auto t_start = std::chrono::steady_clock::now();
+            std::unique_ptr<memex::TranscriptionResult> result = memex::transcribe(
+                *transcriber, n_threads, clip.profile, clip.samples.data(), (int) clip.samples.size(), nullptr);
+            const double latency_ms = elapsed_ms(t_start);
+            if (!result) {
+                std::fprintf(stderr, "%s: transcription failed\n", clip.name.c_str());
+                return run;
+            }
+            if (!timed) {
+                continue;
+            }
+
+            Sample sample;
+            sample.latency_ms = latency_ms;
+            sample.mel_ms = result->mel_ms;
+            sample.encode_ms = result->encode_ms;
+            sample.decode_ms = result->decode_ms();
+            sample.audio_ms = clip.audio_ms();
+            clip_result.samples.push_back(sample);
+            clip_result.text = memex::transcript_text(memex::result_segments(*result));
+        }
+        std::fprintf(stderr, "%s, %d threads: pass %d/%d%s\n", model_path.c_str(), run.n_threads,
+                     pass + 1, opts.warmup + opts.repeat, timed ? "" : " (warm-up)");
+    }
+
+    // Native buffers of the model and its decoder states, and the process as a whole
+    run.context_memory = memex::context_memory(*transcriber->model);
+    run.process_memory = memex::process_memory();
+    run.peak_rss_kb = run.process_memory.peak_rss < 0 ? -1 : (long) (run.process_memory.peak_rss / 1024);
+    run.ok = true;
+    return run;
+}
+
+// Nearest-rank percentile of sorted values
+double percentile(const std::vector<double> & sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t rank = (size_t) std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// Minimal JSON writer; keys and values are emitted in call order
+class Json {
+public:
+    explicit Json(std::string & out) : out_(out) {}
+
+    void begin_object(const char * key = nullptr) { open(key, '{'); }
+    void end_object() { close('}'); }
+    void begin_array(const char * key = nullptr) { open(key, '['); }
+    void end_array() { close(']'); }
+
+    void value(const char * key, const std::string & v) { this->key(key); string(v); }
+    void value(const char * key, const char * v) { value(key, std::string(v)); }
+    void value(const char * key, bool v) { this->key(key); out_ += v ? "true" : "false"; }
+    void value(const char * key, int v) { value(key, (long) v); }
+    void value(const char * key, long v) { this->key(key); out_ += std::to_string(v); }
+    void value(const char * key, long long v) { this->key(key); out_ += std::to_string(v); }
+    void value(const char * key, size_t v) { value(key, (long) v); }
+    void value(const char * key, double v) {
+        this->key(key);
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.3f", std::isfinite(v) ? v : 0.0);
+        out_ += buf;
+    }
+
+private:
+    void key(const char * k) {
+        if (!first_) {
+            out_ += ',';
+        }
+        first_ = false;
+        newline();
+        if (k != nullptr) {
+            string(k);
+            out_ += ": ";
+        }
+    }
+
+    void open(const char * k, char bracket) {
+        key(k);
+        out_ += bracket;
+        ++depth_;
+        first_ = true;
+    }
+
+    void close(char bracket) {
+        --depth_;
+        if (!first_) {
+            newline();
+        }
+        out_ += bracket;
+        first_ = false;
+    }
+
+    void newline() {
+        if (depth_ > 0) {
+            out_ += '\n';
+            out_.append(depth_ * 2, ' ');
+        }
+    }
+
+    void string(const std::string & s) {
+        out_ += '"';
+        for (unsigned char c : s) {
+            switch (c) {
+                case '"':  out_ += "\\\""; break;
+                case '\\': out_ += "\\\\"; break;
+                case '\n': out_ += "\\n"; break;
+                case '\t': out_ += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        out_ += buf;
+                    } else {
+                        out_ += (char) c;
+                    }
+            }
+        }
+        out_ += '"';
+    }
+
+    std::string & out_;
+    int depth_ = 0;
+    bool first_ = true;
+};
+
+// Bytes at the end of the run; -1 where unknown
+void write_memory(Json & json, const memex::ContextMemory & context, const memex::ProcessMemory & process) {
+    json.begin_object("memory");
+    json.value("weights", context.weights);
+    json.value("kv_self", context.kv_self);
+    json.value("kv_cross", context.kv_cross);
+    json.value("compute", context.compute);
+    json.value("scratch", context.scratch);
+    json.value("states", context.n_states);
+    json.value("context_total", context.total());
+    json.value("rss", process.rss);
+    json.value("pss", process.pss);
+    json.value("swap", process.swap);
+    json.end_object();
+}
+
+// Aggregate timings of `samples`: per-stage means, real-time factor and
+// latency percentiles
+void write_summary(Json & json, const char * key, const std::vector<Sample> & samples) {
+    std::vector<double> latencies;
+    double audio_ms = 0.0, total_ms = 0.0, mel_ms = 0.0, encode_ms = 0.0, decode_ms = 0.0;
+    for (const Sample & s : samples) {
+        latencies.push_back(s.latency_ms);
+        audio_ms += s.audio_ms;
+        total_ms += s.latency_ms;
+        mel_ms += s.mel_ms;
+        encode_ms += s.encode_ms;
+        decode_ms += s.decode_ms;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const double n = std::max<size_t>(samples.size(), 1);
+
+    json.begin_object(key);
+    json.value("requests", samples.size());
+    json.value("audio_s", audio_ms / 1000.0);
+    json.value("rtf", audio_ms > 0.0 ? total_ms / audio_ms : 0.0);
+    json.value("mel_ms", mel_ms / n);
+    json.value("encode_ms", encode_ms / n);
+    json.value("decode_ms", decode_ms / n);
+    json.begin_object("latency_ms");
+    json.value("mean", total_ms / n);
+    json.value("p50", percentile(latencies, 50));
+    json.value("p95", percentile(latencies, 95));
+    json.value("p99", percentile(latencies, 99));
+    json.value("max", latencies.empty() ? 0.0 : latencies.back());
+    json.end_object();
+    json.end_object();
+}
+
+std::string to_json(const BenchOptions & opts, const std::vector<Clip> & corpus, const std::vector<RunResult> & runs) {
+    std::string out;
+    Json json(out);
+    json.begin_object();
+    json.value("schema", 1);
+
+    json.begin_object("system");
+    json.value("whisper", whisper_print_system_info());
+    std::string features;
+    for (const std::string & name : memex::detect_cpu_features().names()) {
+        features += features.empty() ? name : " " + name;
+    }
+    json.value("cpu_features", features);
+    json.value("default_threads", memex::default_thread_count());
+    json.value("openmp", memex::openmp_enabled());
+    json.end_object();
+
+    json.begin_object("corpus");
+    json.value("dir", opts.corpus);
+    json.value("warmup", opts.warmup);
+    json.value("repeat", opts.repeat);
+    json.begin_array("clips");
+    for (const Clip & clip : corpus) {
+        json.begin_object();
+        json.value("name", clip.name);
+        json.value("profile", memex::decode_profile(clip.profile).name);
+        json.value("audio_ms", clip.audio_ms());
+        json.end_object();
+    }
+    json.end_array();
+    json.end_object();
+
+    json.begin_array("runs");
+    for (const RunResult & run : runs) {
+        json.begin_object();
+        json.value("model", run.model);
+        json.value("threads", run.n_threads);
+        json.value("ok", run.ok);
+        json.value("load_ms", run.load_ms);
+        json.value("peak_rss_kb", run.peak_rss_kb);
+        write_memory(json, run.context_memory, run.process_memory);
+
+        std::vector<Sample> all;
+        json.begin_object("categories");
+        for (const char * category : kCategories) {
+            std::vector<Sample> samples;
+            for (const ClipResult & clip : run.clips) {
+                if (clip.clip->category == category) {
+                    samples.insert(samples.end(), clip.samples.begin(), clip.samples.end());
+                }
+            }
+            all.insert(all.end(), samples.begin(), samples.end());
+            write_summary(json, category, samples);
+        }
+        json.end_object();
+        write_summary(json, "overall", all);
+
+        json.begin_array("clips");
+        for (const ClipResult & clip : run.clips) {
+            std::vector<double> latencies;
+            for (const Sample & s : clip.samples) {
+                latencies.push_back(s.latency_ms);
+            }
+            std::sort(latencies.begin(), latencies.end());
+            json.begin_object();
+            json.value("name", clip.clip->name);
+            json.value("latency_p50_ms", percentile(latencies, 50));
+            json.value("text", clip.text);
+            json.end_object();
+        }
+        json.end_array();
+        json.end_object();
+    }
+    json.end_array();
+
+    json.end_object();
+    out += '\n';
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    BenchOptions opts;
+    if (!parse_args(argc, argv, opts)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+#ifndef __ANDROID__
+    memex::host_log_level = opts.verbose ? memex::LOG_LEVEL_INFO : memex::LOG_LEVEL_WARN;
+#endif
+
+    std::vector<Clip> corpus;
+    if (!load_corpus(opts.corpus, corpus)) {
+        std::fprintf(stderr, "no clips found under %s/{command,dictation}\n", opts.corpus.c_str());
+        return 1;
+    }
+
+    std::vector<RunResult> runs;
+    bool ok = true;
+    for (const std::string & model : opts.models) {
+        for (int n_threads : opts.threads) {
+            runs.push_back(run_config(model, n_threads, corpus, opts));
+            ok = ok && runs.back().ok;
+        }
+    }
+
+    const std::string json = to_json(opts, corpus, runs);
+    if (opts.output.empty()) {
+        std::fputs(json.c_str(), stdout);
+    } else {
+        std::ofstream out(opts.output);
+        out << json;
+        if (!out) {
+            std::fprintf(stderr, "failed to write %s\n", opts.output.c_str());
+            return 1;
+        }
+    }
+    return ok ? 0 : 1;
+}
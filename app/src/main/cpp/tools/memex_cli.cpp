@@ -0,0 +1,258 @@
+// memex-cli: transcribe WAV files on a workstation through the same native
+// code paths the app uses (model registry, state pool, VAD, decode profiles,
+// cascade, long-form and speculative decoding), so they can be profiled with
+// perf and benchmarked off-device.
+//
+//   memex-cli -m models/ggml-base.bin [options] file.wav...
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cpu_topology.h"
+#include "decode_profile.h"
+#include "log.h"
+#include "trace.h"
+#include "transcriber.h"
+#include "wav_reader.h"
+
+namespace {
+
+struct CliOptions {
+    std::string model;
+    std::string cascade_model;
+    float cascade_threshold = 0.6f;
+    std::string draft_model;
+    int n_draft = 4;
+    std::string grammar_file;
+    std::string trace_file;
+    int n_threads = 0;
+    int profile = memex::PROFILE_DEFAULT;
+    bool vad = false;
+    bool long_form = false;
+    bool timestamps = false;
+    bool verbose = false;
+    std::vector<std::string> files;
+};
+
+void print_usage(const char * argv0) {
+    std::fprintf(stderr,
+        "usage: %s -m MODEL [options] FILE.wav...\n"
+        "\n"
+        "  -m, --model PATH       ggml whisper model\n"
+        "  -t, --threads N        decode threads (default 0: one per performance core)\n"
+        "  -p, --profile NAME     default, command, dictation, long-form or streaming\n"
+        "      --vad              trim silence with the VAD before decoding\n"
+        "      --long             long-form transcription over VAD chunks\n"
+        "      --cascade PATH     re-decode low-confidence transcripts with PATH\n"
+        "      --threshold F      cascade confidence threshold (default 0.6)\n"
+        "      --draft PATH       speculative decoding with draft model PATH\n"
+        "      --draft-tokens N   tokens drafted per round, 1-16 (default 4)\n"
+        "      --grammar FILE     GBNF grammar for the command profile\n"
+        "      --timestamps       print segment times\n"
+        "      --trace FILE       write per-stage timings as Chrome trace JSON\n"
+        "  -v, --verbose          log native info messages\n",
+        argv0);
+}
+
+int profile_from_name(const std::string & name) {
+    for (const memex::DecodeProfile & profile : memex::kDecodeProfiles) {
+        if (name == profile.name) {
+            return profile.id;
+        }
+    }
+    return -1;
+}
+
+bool parse_args(int argc, char ** argv, CliOptions & opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> const char * {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+        const char * v = nullptr;
+
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (arg == "-m" || arg == "--model") {
+            if ((v = value()) == nullptr) return false;
+            opts.model = v;
+        } else if (arg == "-t" || arg == "--threads") {
+            if ((v = value()) == nullptr) return false;
+            opts.n_threads = std::atoi(v);
+        } else if (arg == "-p" || arg == "--profile") {
+            if ((v = value()) == nullptr) return false;
+            opts.profile = profile_from_name(v);
+            if (opts.profile < 0) {
+                std::fprintf(stderr, "unknown profile: %s\n", v);
+                return false;
+            }
+        } else if (arg == "--vad") {
+            opts.vad = true;
+        } else if (arg == "--long") {
+            opts.long_form = true;
+        } else if (arg == "--cascade") {
+            if ((v = value()) == nullptr) return false;
+            opts.cascade_model = v;
+        } else if (arg == "--threshold") {
+            if ((v = value()) == nullptr) return false;
+            opts.cascade_threshold = (float) std::atof(v);
+        } else if (arg == "--draft") {
+            if ((v = value()) == nullptr) return false;
+            opts.draft_model = v;
+        } else if (arg == "--draft-tokens") {
+            if ((v = value()) == nullptr) return false;
+            opts.n_draft = std::atoi(v);
+        } else if (arg == "--grammar") {
+            if ((v = value()) == nullptr) return false;
+            opts.grammar_file = v;
+        } else if (arg == "--trace") {
+            if ((v = value()) == nullptr) return false;
+            opts.trace_file = v;
+        } else if (arg == "--timestamps") {
+            opts.timestamps = true;
+        } else if (arg == "-v" || arg == "--verbose") {
+            opts.verbose = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            return false;
+        } else {
+            opts.files.push_back(arg);
+        }
+    }
+    return !opts.model.empty() && !opts.files.empty();
+}
+
+bool configure(memex::Transcriber & transcriber, const CliOptions & opts) {
+    std::shared_ptr<memex::VadSettings> vad = std::make_shared<memex::VadSettings>();
+    vad->enabled = opts.vad;
+    transcriber.vad = std::move(vad);
+
+    if (!opts.grammar_file.empty()) {
+        std::ifstream in(opts.grammar_file);
+        std::stringstream text;
+        text << in.rdbuf();
+        std::shared_ptr<memex::CommandGrammar> grammar = std::make_shared<memex::CommandGrammar>();
+        std::string error;
+        if (!in || !grammar->grammar.parse(text.str(), &error)) {
+            std::fprintf(stderr, "failed to load grammar %s: %s\n", opts.grammar_file.c_str(), error.c_str());
+            return false;
+        }
+        transcriber.grammar = std::move(grammar);
+    }
+
+    if (!opts.cascade_model.empty()) {
+        std::shared_ptr<memex::Cascade> cascade = std::make_shared<memex::Cascade>();
+        cascade->model = memex::acquire_model_file(opts.cascade_model);
+        cascade->threshold = opts.cascade_threshold;
+        if (!cascade->model) {
+            std::fprintf(stderr, "failed to load cascade model %s\n", opts.cascade_model.c_str());
+            return false;
+        }
+        transcriber.cascade = std::move(cascade);
+    }
+
+    if (!opts.draft_model.empty()) {
+        transcriber.draft = memex::acquire_model_file(opts.draft_model);
+        if (!transcriber.draft) {
+            std::fprintf(stderr, "failed to load draft model %s\n", opts.draft_model.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<memex::TranscriptionResult> run(memex::Transcriber & transcriber, const CliOptions & opts,
+                                                const std::vector<float> & pcmf32) {
+    if (opts.long_form) {
+        memex::LongFormParams params;
+        params.n_threads = opts.n_threads;
+        return memex::transcribe_long_form(transcriber, params, pcmf32.data(), pcmf32.size(), nullptr);
+    }
+    if (transcriber.draft) {
+        memex::SpeculativeParams params;
+        params.n_draft = opts.n_draft;
+        params.n_threads = opts.n_threads;
+        return memex::transcribe_with_draft(transcriber, params, pcmf32.data(), (int) pcmf32.size(), nullptr);
+    }
+    return memex::transcribe(transcriber, opts.n_threads, opts.profile, pcmf32.data(), (int) pcmf32.size(), nullptr);
+}
+
+void print_time(int64_t ms) {
+    std::printf("%02lld:%02lld.%03lld", (long long) (ms / 60000), (long long) (ms / 1000 % 60), (long long) (ms % 1000));
+}
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    CliOptions opts;
+    if (!parse_args(argc, argv, opts)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+#ifndef __ANDROID__
+    memex::host_log_level = opts.verbose ? memex::LOG_LEVEL_INFO : memex::LOG_LEVEL_WARN;
+#endif
+
+    const auto t_load = std::chrono::steady_clock::now();
+    std::unique_ptr<memex::Transcriber> transcriber = memex::make_transcriber(memex::acquire_model_file(opts.model));
+    if (!transcriber) {
+        std::fprintf(stderr, "failed to load model %s\n", opts.model.c_str());
+        return 1;
+    }
+    if (!configure(*transcriber, opts)) {
+        return 1;
+    }
+    const double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_load).count();
+    std::fprintf(stderr, "loaded %s in %.0f ms, %d decode threads\n",
+                 opts.model.c_str(), load_ms, memex::resolve_thread_count(opts.n_threads));
+
+    int n_failed = 0;
+    for (const std::string & file : opts.files) {
+        std::vector<float> pcmf32 = memex::read_wav(file);
+        if (pcmf32.empty()) {
+            std::fprintf(stderr, "%s: failed to read audio\n", file.c_str());
+            ++n_failed;
+            continue;
+        }
+
+        const auto t_start = std::chrono::steady_clock::now();
+        std::unique_ptr<memex::TranscriptionResult> result = run(*transcriber, opts, pcmf32);
+        const double decode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+        if (!result) {
+            std::fprintf(stderr, "%s: transcription failed\n", file.c_str());
+            ++n_failed;
+            continue;
+        }
+
+        const std::vector<memex::TranscriptSegment> segments = memex::result_segments(*result);
+        if (opts.timestamps) {
+            std::printf("%s:\n", file.c_str());
+            for (const memex::TranscriptSegment & seg : segments) {
+                std::printf("[");
+                print_time(seg.t0_ms);
+                std::printf(" --> ");
+                print_time(seg.t1_ms);
+                std::printf("] %s\n", seg.text.c_str());
+            }
+        } else {
+            std::printf("%s:%s\n", file.c_str(), memex::transcript_text(segments).c_str());
+        }
+
+        const double audio_ms = pcmf32.size() * 1000.0 / WHISPER_SAMPLE_RATE;
+        std::fprintf(stderr, "%s: %.2f s audio, %.0f ms, RTF %.3f, confidence %.2f\n",
+                     file.c_str(), audio_ms / 1000.0, decode_ms, decode_ms / audio_ms,
+                     memex::transcript_confidence(segments));
+    }
+
+    if (!opts.trace_file.empty() &&
+        !memex::write_chrome_trace(opts.trace_file, memex::TraceBuffer::instance().snapshot())) {
+        std::fprintf(stderr, "failed to write trace %s\n", opts.trace_file.c_str());
+        ++n_failed;
+    }
+    return n_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "trace.h"
+
+#include <cstdio>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "log.h"
+
+namespace memex {
+
+namespace {
+
+constexpr const char * kStageNames[STAGE_COUNT] = {
+    "load", "jni_input", "vad", "state_wait", "mel", "encode", "decode", "request", "jni_export",
+};
+
+std::atomic<uint64_t> g_next_request_id{1};
+thread_local uint64_t t_request_id = 0;
+
+int current_tid() {
+    static thread_local int tid = (int) syscall(SYS_gettid);
+    return tid;
+}
+
+} // namespace
+
+const char * trace_stage_name(int stage) {
+    return stage >= 0 && stage < STAGE_COUNT ? kStageNames[stage] : "unknown";
+}
+
+TraceBuffer & TraceBuffer::instance() {
+    static TraceBuffer buffer;
+    return buffer;
+}
+
+void TraceBuffer::record(uint64_t request_id, int stage, int64_t start_us, int64_t dur_us) {
+    const uint64_t seq = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot & slot = slots_[seq % kCapacity];
+
+    slot.stamp.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.request_id.store(request_id, std::memory_order_relaxed);
+    slot.stage.store(stage, std::memory_order_relaxed);
+    slot.tid.store(current_tid(), std::memory_order_relaxed);
+    slot.start_us.store(start_us, std::memory_order_relaxed);
+    slot.dur_us.store(dur_us, std::memory_order_relaxed);
+    slot.stamp.store(2 * (seq + 1), std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceBuffer::snapshot(uint64_t since) const {
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t first = head > kCapacity ? head - kCapacity : 0;
+    if (since > first) {
+        first = since;
+    }
+
+    std::vector<TraceEvent> events;
+    events.reserve(head > first ? head - first : 0);
+    for (uint64_t seq = first; seq < head; ++seq) {
+        const Slot & slot = slots_[seq % kCapacity];
+        const uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+        if (stamp < 2 * (seq + 1)) {
+            // Claimed but not yet published: stop here so a caller resuming
+            // after the last span returned still gets this one
+            break;
+        }
+        if (stamp != 2 * (seq + 1)) {
+            continue;  // already overwritten by a later span
+        }
+
+        TraceEvent event;
+        event.seq        = seq;
+        event.request_id = slot.request_id.load(std::memory_order_relaxed);
+        event.stage      = slot.stage.load(std::memory_order_relaxed);
+        event.tid        = slot.tid.load(std::memory_order_relaxed);
+        event.start_us   = slot.start_us.load(std::memory_order_relaxed);
+        event.dur_us     = slot.dur_us.load(std::memory_order_relaxed);
+
+        // A writer that lapped us while we read invalidates the copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.stamp.load(std::memory_order_relaxed) == stamp) {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+uint64_t next_request_id() {
+    return g_next_request_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t current_request_id() {
+    return t_request_id;
+}
+
+TraceScope::TraceScope() : id_(t_request_id), owner_(t_request_id == 0) {
+    if (owner_) {
+        id_ = next_request_id();
+        t_request_id = id_;
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (owner_) {
+        t_request_id = 0;
+    }
+}
+
+bool write_chrome_trace(const std::string & path, const std::vector<TraceEvent> & events) {
+    FILE * f = std::fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        LOGE("Failed to open trace file %s", path.c_str());
+        return false;
+    }
+
+    const int pid = (int) getpid();
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent & e = events[i];
+        std::fprintf(f,
+            "%s\n{\"name\":\"%s\",\"cat\":\"whisper\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+            "\"pid\":%d,\"tid\":%d,\"args\":{\"request\":%llu}}",
+            i > 0 ? "," : "", trace_stage_name(e.stage), (long long) e.start_us, (long long) e.dur_us,
+            pid, e.tid, (unsigned long long) e.request_id);
+    }
+    std::fprintf(f, "\n]}\n");
+
+    const bool ok = std::fclose(f) == 0;
+    if (ok) {
+        LOGI("Wrote %zu trace events to %s", events.size(), path.c_str());
+    }
+    return ok;
+}
+
+} // namespace memex
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memex {
+
+// Stages of a native request, shared with Kotlin (TraceStage)
+enum TraceStageId : int {
+    STAGE_LOAD       = 0,  // model load on a registry miss
+    STAGE_JNI_INPUT  = 1,  // copying or converting the request's audio from Java
+    STAGE_VAD        = 2,  // speech detection and gathering
+    STAGE_STATE_WAIT = 3,  // waiting for a free decoder state
+    STAGE_MEL        = 4,  // log-mel spectrogram
+    STAGE_ENCODE     = 5,  // encoder, up to the first decoder logits
+    STAGE_DECODE     = 6,  // token decoding
+    STAGE_REQUEST    = 7,  // the whole native request
+    STAGE_JNI_EXPORT = 8,  // serialising the result into a Java buffer
+    STAGE_COUNT
+};
+
+const char * trace_stage_name(int stage);
+
+// One timed span. Times are microseconds on the steady clock.
+struct TraceEvent {
+    uint64_t seq = 0;         // position in the trace, increasing
+    uint64_t request_id = 0;  // 0 for work outside a request, e.g. loads
+    int stage = 0;
+    int tid = 0;
+    int64_t start_us = 0;
+    int64_t dur_us = 0;
+};
+
+// Process-wide ring of the most recent kCapacity spans. record() is
+// lock-free and wait-free, so it is safe on decode threads: a writer claims
+// a slot with one fetch_add and publishes it with a sequence stamp. Readers
+// stop at the first slot still being written and skip slots already
+// rewritten; once the ring wraps, the oldest spans are lost.
+class TraceBuffer {
+public:
+    static constexpr size_t kCapacity = 4096;
+
+    static TraceBuffer & instance();
+
+    void record(uint64_t request_id, int stage, int64_t start_us, int64_t dur_us);
+
+    // Spans with seq >= `since` still in the ring, oldest first, up to the
+    // first span not yet published. Resuming from the last seq returned + 1
+    // therefore never passes over a span that is still being written.
+    std::vector<TraceEvent> snapshot(uint64_t since = 0) const;
+
+    // Sequence number the next span will get.
+    uint64_t next_seq() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    TraceBuffer() = default;
+
+    struct Slot {
+        // 0 = empty, odd = being written, 2 * (seq + 1) = holds span `seq`
+        std::atomic<uint64_t> stamp{0};
+        std::atomic<uint64_t> request_id{0};
+        std::atomic<int> stage{0};
+        std::atomic<int> tid{0};
+        std::atomic<int64_t> start_us{0};
+        std::atomic<int64_t> dur_us{0};
+    };
+
+    std::atomic<uint64_t> head_{0};
+    Slot slots_[kCapacity];
+};
+
+// Microseconds on the clock spans are recorded with.
+inline int64_t trace_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A new request id, never 0.
+uint64_t next_request_id();
+
+// Request id of the calling thread's current TraceScope, or 0.
+uint64_t current_request_id();
+
+// Gives the calling thread a request id for its lifetime, so spans recorded
+// by the JNI entry point and by memex_core share it. Nested scopes keep the
+// outer id.
+class TraceScope {
+public:
+    TraceScope();
+    ~TraceScope();
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope & operator=(const TraceScope &) = delete;
+
+    uint64_t id() const { return id_; }
+
+private:
+    uint64_t id_;
+    bool owner_;
+};
+
+// Records a span of `stage` from construction to destruction.
+class TraceSpan {
+public:
+    explicit TraceSpan(int stage, uint64_t request_id = current_request_id())
+        : stage_(stage), request_id_(request_id), start_us_(trace_now_us()) {}
+    ~TraceSpan() { TraceBuffer::instance().record(request_id_, stage_, start_us_, trace_now_us() - start_us_); }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan & operator=(const TraceSpan &) = delete;
+
+private:
+    int stage_;
+    uint64_t request_id_;
+    int64_t start_us_;
+};
+
+// Write `events` as Chrome trace event JSON ("X" complete events), which
+// chrome://tracing and ui.perfetto.dev open directly. Returns false if the
+// file cannot be written.
+bool write_chrome_trace(const std::string & path, const std::vector<TraceEvent> & events);
+
+} // namespace memex
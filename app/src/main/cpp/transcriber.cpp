@@ -0,0 +1,481 @@
+#include "transcriber.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "audio_ctx.h"
+#include "compute_pool.h"
+#include "cpu_topology.h"
+#include "decode_profile.h"
+#include "log.h"
+#include "trace.h"
+
+namespace memex {
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Record a request's encoder time, summed over its `n_windows` windows.
+// Full-window runs update the model's per-window baseline; shorter contexts
+// report their saving against it.
+void record_encode_time(TranscriptionResult & result, int audio_ctx, double encode_ms, int n_windows) {
+    if (encode_ms <= 0.0) {
+        return;
+    }
+
+    Model & model = *result.model;
+    result.audio_ctx = audio_ctx;
+    result.encode_ms = encode_ms;
+
+    if (audio_ctx == 0) {
+        // Concurrent decodes on the model may update the average together
+        const float window_ms = (float) (encode_ms / std::max(1, n_windows));
+        float prev = model.full_window_encode_ms.load();
+        float next;
+        do {
+            next = prev > 0.0f ? 0.8f * prev + 0.2f * window_ms : window_ms;
+        } while (!model.full_window_encode_ms.compare_exchange_weak(prev, next));
+        return;
+    }
+
+    // Until a full window has been measured, scale linearly with the context.
+    // That underestimates the saving since attention grows faster than linearly.
+    const int n_audio_ctx = whisper_model_n_audio_ctx(model.ctx);
+    float full_ms = model.full_window_encode_ms.load();
+    const bool estimated = full_ms <= 0.0f;
+    if (estimated) {
+        full_ms = (float) (encode_ms * n_audio_ctx / audio_ctx);
+    }
+    result.encode_saved_ms = std::max(0.0, full_ms - encode_ms);
+
+    LOGI("audio_ctx %d/%d: encoder %.0f ms, %.0f ms saved vs full window%s",
+         audio_ctx, n_audio_ctx, encode_ms, result.encode_saved_ms, estimated ? " (estimated)" : "");
+}
+
+// Split the whisper_full call that started at `t_full_us` into mel, encoder
+// and decoder spans of the result's request. A long clip's encoder windows
+// are interleaved with decoding; they are drawn as one span of their total.
+// Recorded on the compute worker, so the spans carry the thread that ran them.
+void record_stage_spans(const TranscriptionResult & result, int64_t t_full_us, double mel_ms, double encode_ms) {
+    TraceBuffer & trace = TraceBuffer::instance();
+    const int64_t mel_us = (int64_t) (mel_ms * 1000.0);
+    const int64_t encode_us = (int64_t) (encode_ms * 1000.0);
+    const int64_t full_us = (int64_t) (result.full_ms * 1000.0);
+
+    trace.record(result.trace_id, STAGE_MEL, t_full_us, mel_us);
+    trace.record(result.trace_id, STAGE_ENCODE, t_full_us + mel_us, encode_us);
+    trace.record(result.trace_id, STAGE_DECODE, t_full_us + mel_us + encode_us,
+                 std::max<int64_t>(0, full_us - mel_us - encode_us));
+}
+
+// Run whisper_full on the result's leased decoder state and record its
+// encoder time. `cancel` (may be null) can stop the decode early. Returns
+// whisper's status code.
+int run_full(TranscriptionResult & result,
+             whisper_full_params wparams,
+             const float * samples,
+             int n_samples,
+             CancelToken * cancel) {
+
+    LOGI("Processing %d audio samples with %d threads", n_samples, wparams.n_threads);
+
+    if (cancel != nullptr) {
+        cancel->attach(wparams);
+    }
+    EncodeTimer timer;
+    timer.attach(wparams);
+
+    // Process audio on a persistent compute worker, pinned to the performance cores
+    int status = -1;
+    ComputePool::instance().run([&] {
+        ScopedCorePinning pinning;
+        const auto t_full = std::chrono::steady_clock::now();
+        const int64_t t_full_us = trace_now_us();
+        timer.start();
+        status = whisper_full_with_state(result.model->ctx, result.lease.get(), wparams, samples, n_samples);
+        result.full_ms = elapsed_ms(t_full);
+        if (status == 0) {
+            record_stage_spans(result, t_full_us, timer.mel_ms(), timer.encode_ms());
+        }
+    });
+
+    if (cancel != nullptr) {
+        cancel->on_decode_returned();
+        if (status != 0 && cancel->should_abort()) {
+            LOGI("Decode %s, threads idle %.1f ms later",
+                 cancel->cancelled() ? "cancelled" : "past its deadline", cancel->idle_latency_ms());
+            return status;
+        }
+    }
+
+    if (status != 0) {
+        LOGE("Failed to process audio, error code: %d", status);
+        return status;
+    }
+
+    LOGI("Audio processing completed successfully");
+    result.mel_ms = timer.mel_ms();
+    record_encode_time(result, wparams.audio_ctx, timer.encode_ms(), timer.n_windows());
+    return status;
+}
+
+// Lease a decoder state of `result.model` (or reuse the one the result
+// already holds) and decode `samples` on it with profile `profile_id`.
+// Profiles with an adaptive audio_ctx size the encoder context to the clip
+// for this model. `grammar` and `forwarder` are optional. Returns whisper's
+// status code, or -1 if no decode ran.
+int decode_on_model(TranscriptionResult & result,
+                    int profile_id,
+                    int n_threads,
+                    const CommandGrammar * grammar,
+                    SegmentForwarder * forwarder,
+                    const float * samples,
+                    int n_samples,
+                    CancelToken * cancel) {
+
+    // Lease a decoder state unless the result already holds one; blocks
+    // while every pooled state is busy
+    if (!result.lease) {
+        StatePool * pool = result.model->states.get();
+        TraceSpan wait(STAGE_STATE_WAIT, result.trace_id);
+        result.lease = StateLease(pool, pool->acquire());
+    }
+    if (!result.lease) {
+        LOGE("No decoder state available");
+        return -1;
+    }
+
+    // The wait for a state may have outlived the request
+    if (cancel != nullptr && cancel->should_abort()) {
+        LOGI("Request cancelled before decoding");
+        return -1;
+    }
+
+    const DecodeProfile & profile = decode_profile(profile_id);
+    whisper_full_params wparams = full_params_for(profile_id, n_threads);
+    if (profile.adaptive_audio_ctx) {
+        wparams.audio_ctx = adaptive_audio_ctx(result.model->ctx, n_samples);
+    }
+    if (grammar != nullptr) {
+        grammar->grammar.apply(wparams, grammar->penalty);
+    }
+    if (forwarder != nullptr) {
+        forwarder->attach(wparams);
+    }
+
+    return run_full(result, wparams, samples, n_samples, cancel);
+}
+
+// Called once every worker has joined. Returns true if the request was
+// cancelled or ran past its deadline.
+bool aborted(CancelToken * cancel, const char * what) {
+    if (cancel == nullptr) {
+        return false;
+    }
+    cancel->on_decode_returned();
+    if (!cancel->should_abort()) {
+        return false;
+    }
+    LOGI("%s decode %s, threads idle %.1f ms later",
+         what, cancel->cancelled() ? "cancelled" : "past its deadline", cancel->idle_latency_ms());
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<Model> acquire_model_file(const std::string & model_path) {
+    struct whisper_context_params cparams = whisper_context_default_params();
+    return ModelRegistry::instance().acquire(model_path, cparams);
+}
+
+std::unique_ptr<Transcriber> make_transcriber(std::shared_ptr<Model> model) {
+    if (!model) {
+        return nullptr;
+    }
+
+    ComputePool::instance().reserve(model->states->max_states());
+    std::unique_ptr<Transcriber> transcriber(new Transcriber());
+    transcriber->model = std::move(model);
+    return transcriber;
+}
+
+std::unique_ptr<TranscriptionResult> transcribe(Transcriber & transcriber,
+                                                int n_threads,
+                                                int profile_id,
+                                                const float * samples,
+                                                int n_samples,
+                                                CancelToken * cancel) {
+
+    TraceScope scope;
+    TraceSpan request(STAGE_REQUEST);
+
+    std::unique_ptr<TranscriptionResult> result(new TranscriptionResult());
+    result->model = transcriber.model;
+    result->trace_id = scope.id();
+
+    // Gathered speech is per request: it is at most the clip's size and a
+    // one-off allocation next to the decode, where a per-thread buffer would
+    // keep the longest clip a thread ever saw
+    std::vector<float> speech;
+    std::shared_ptr<const VadSettings> vad = std::atomic_load(&transcriber.vad);
+    if (vad->enabled) {
+        TraceSpan span(STAGE_VAD);
+        result->speech = detect_speech(samples, (size_t) n_samples, vad->params);
+        if (result->speech.empty()) {
+            LOGI("VAD found no speech in %d samples, skipping decode", n_samples);
+            return result;
+        }
+
+        const size_t n_speech = gather_speech(samples, result->speech, kSpeechGapMs,
+                                              vad->params.sample_rate, speech);
+        LOGI("VAD kept %zu of %d samples in %zu segment(s)", n_speech, n_samples, result->speech.size());
+        samples = speech.data();
+        n_samples = (int) speech.size();
+    }
+
+    const DecodeProfile & profile = decode_profile(profile_id);
+    LOGI("Decode profile: %s", profile.name);
+
+    // Held until the decode returns
+    std::shared_ptr<const CommandGrammar> grammar;
+    if (profile.use_grammar) {
+        grammar = std::atomic_load(&transcriber.grammar);
+    }
+
+    // Push segments to the listener as they are decoded, in clip time
+    std::unique_ptr<SegmentForwarder> forwarder;
+    std::shared_ptr<const TranscriptionListener> listener = std::atomic_load(&transcriber.listener);
+    if (listener) {
+        forwarder.reset(new SegmentForwarder(std::move(listener), &result->speech, kSpeechGapMs,
+                                             vad->params.sample_rate));
+    }
+
+    // A cascade may discard the primary transcript, so the listener only
+    // hears the one that is kept: the primary's segments are held back until
+    // the cascade has decided
+    std::shared_ptr<const Cascade> cascade = std::atomic_load(&transcriber.cascade);
+    SegmentForwarder * primary_forwarder = cascade ? nullptr : forwarder.get();
+
+    const auto t_start = std::chrono::steady_clock::now();
+    if (decode_on_model(*result, profile_id, n_threads, grammar.get(), primary_forwarder,
+                        samples, n_samples, cancel) != 0) {
+        return nullptr;
+    }
+
+    if (!cascade) {
+        return result;
+    }
+
+    // Cascade: keep the primary transcript unless its confidence is too low,
+    // then re-decode the same audio with the larger model
+    const double primary_ms = elapsed_ms(t_start);
+    const float confidence = transcript_confidence(segments_from_state(result->model->ctx, result->lease.get()));
+    const bool escalate = confidence < cascade->threshold;
+    double fallback_ms = 0.0;
+
+    if (escalate) {
+        LOGI("Cascade: confidence %.2f below %.2f after %.0f ms, re-decoding with %s",
+             confidence, cascade->threshold, primary_ms, cascade->model->key.c_str());
+
+        const auto t_fallback = std::chrono::steady_clock::now();
+        result->lease = StateLease();  // back to the primary pool before switching models
+        result->model = cascade->model;
+        if (decode_on_model(*result, profile_id, n_threads, grammar.get(), forwarder.get(),
+                            samples, n_samples, cancel) != 0) {
+            return nullptr;
+        }
+        fallback_ms = elapsed_ms(t_fallback);
+    } else if (forwarder) {
+        forwarder->replay(result->lease.get());
+    }
+
+    transcriber.cascade_stats.record(confidence, escalate, primary_ms, fallback_ms);
+    return result;
+}
+
+std::unique_ptr<TranscriptionResult> transcribe_long_form(Transcriber & transcriber,
+                                                          LongFormParams params,
+                                                          const float * samples,
+                                                          size_t n_samples,
+                                                          CancelToken * cancel) {
+
+    TraceScope scope;
+    TraceSpan request(STAGE_REQUEST);
+
+    params.vad = std::atomic_load(&transcriber.vad)->params;
+
+    // Stitched segments are pushed as each chunk finishes
+    std::shared_ptr<const TranscriptionListener> listener = std::atomic_load(&transcriber.listener);
+    int n_pushed = 0;
+    if (listener) {
+        params.on_segment = [&](const TranscriptSegment & seg) {
+            listener->on_segment(n_pushed++, seg.t0_ms, seg.t1_ms, seg.text.c_str());
+        };
+        params.on_chunk_done = [&](int done, int total) {
+            listener->on_progress(done * 100 / total);
+        };
+    }
+
+    whisper_full_params wparams = full_params_for(PROFILE_LONG_FORM, params.n_threads);
+    if (cancel != nullptr) {
+        cancel->attach(wparams);
+    }
+
+    LongFormResult longform = transcribe_long(transcriber.model, wparams, samples, n_samples, params);
+    if (aborted(cancel, "Long-form") || !longform.ok) {
+        return nullptr;
+    }
+
+    std::unique_ptr<TranscriptionResult> result(new TranscriptionResult());
+    result->model = transcriber.model;
+    result->trace_id = scope.id();
+    result->segments = std::move(longform.segments);
+    result->chunks = std::move(longform.chunks);
+    return result;
+}
+
+std::unique_ptr<TranscriptionResult> transcribe_with_draft(Transcriber & transcriber,
+                                                           const SpeculativeParams & params,
+                                                           const float * samples,
+                                                           int n_samples,
+                                                           CancelToken * cancel) {
+
+    TraceScope scope;
+    TraceSpan request(STAGE_REQUEST);
+
+    std::shared_ptr<Model> draft = std::atomic_load(&transcriber.draft);
+    if (!draft) {
+        LOGE("Speculative decoding needs a draft model");
+        return nullptr;
+    }
+
+    // The draft state is only taken if free, so a request never holds one
+    // pool while waiting on another
+    StatePool * target_pool = transcriber.model->states.get();
+    StateLease target_lease;
+    {
+        TraceSpan wait(STAGE_STATE_WAIT);
+        target_lease = StateLease(target_pool, target_pool->acquire());
+    }
+    if (!target_lease) {
+        LOGE("No decoder state available");
+        return nullptr;
+    }
+    StateLease draft_lease(draft->states.get(), draft->states->try_acquire());
+    if (!draft_lease) {
+        // A busy draft model only costs the speedup: decode plainly on the
+        // target state already held
+        LOGI("No free draft decoder state, decoding without a draft");
+        std::unique_ptr<TranscriptionResult> result(new TranscriptionResult());
+        result->model = transcriber.model;
+        result->trace_id = scope.id();
+        result->lease = std::move(target_lease);
+        if (decode_on_model(*result, PROFILE_DEFAULT, params.n_threads, nullptr, nullptr,
+                            samples, n_samples, cancel) != 0) {
+            return nullptr;
+        }
+        return result;
+    }
+
+    SpeculativeResult speculative;
+    ComputePool::instance().run([&] {
+        ScopedCorePinning pinning;
+        speculative = transcribe_speculative(*transcriber.model, target_lease.get(), *draft, draft_lease.get(),
+                                             samples, n_samples, params, cancel);
+    });
+
+    if (aborted(cancel, "Speculative") || !speculative.ok) {
+        return nullptr;
+    }
+
+    // The text is copied out, so neither state stays leased
+    std::unique_ptr<TranscriptionResult> result(new TranscriptionResult());
+    result->model = transcriber.model;
+    result->trace_id = scope.id();
+    if (!speculative.segment.tokens.empty()) {
+        result->segments.push_back(std::move(speculative.segment));
+    }
+    result->speculative = speculative.stats;
+    return result;
+}
+
+ThreadStartupCost measure_thread_startup(Model & model,
+                                         int n_threads,
+                                         int iterations,
+                                         const float * samples,
+                                         int n_samples) {
+    ThreadStartupCost cost;
+    cost.n_threads = std::max(1, n_threads);
+    iterations = std::max(1, iterations);
+
+    StateLease lease(model.states.get(), model.states->acquire());
+    if (!lease) {
+        LOGE("No decoder state available");
+        return cost;
+    }
+
+    const whisper_full_params wparams = full_params_for(PROFILE_DEFAULT, cost.n_threads);
+    bool ok = true;
+    auto decode = [&] {
+        ScopedCorePinning pinning;
+        if (whisper_full_with_state(model.ctx, lease.get(), wparams, samples, n_samples) != 0) {
+            ok = false;
+        }
+    };
+
+    ComputePool::instance().run(decode);
+    auto t_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        ComputePool::instance().run(decode);
+    }
+    const double pooled_ms = elapsed_ms(t_start) / iterations;
+
+    t_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        std::thread([&decode] {
+            set_openmp_blocktime();
+            decode();
+        }).join();
+    }
+    const double spawned_ms = elapsed_ms(t_start) / iterations;
+
+    if (!ok) {
+        LOGE("Decode failed while measuring thread start-up");
+        return cost;
+    }
+    cost.spawned_ms = spawned_ms;
+    cost.pooled_ms = pooled_ms;
+    LOGI("whisper_full with %d threads: %.1f ms on a fresh thread, %.1f ms on a pool worker",
+         cost.n_threads, cost.spawned_ms, cost.pooled_ms);
+    return cost;
+}
+
+std::vector<TranscriptSegment> result_segments(const TranscriptionResult & result) {
+    struct whisper_state * state = result.lease.get();
+    if (state == nullptr) {
+        // Long-form and speculative results, or no speech found
+        return result.segments;
+    }
+
+    std::vector<TranscriptSegment> segments = segments_from_state(result.model->ctx, state);
+    if (!result.speech.empty()) {
+        for (TranscriptSegment & seg : segments) {
+            seg.t0_ms = gathered_to_source_ms(seg.t0_ms, result.speech, kSpeechGapMs, WHISPER_SAMPLE_RATE);
+            seg.t1_ms = gathered_to_source_ms(seg.t1_ms, result.speech, kSpeechGapMs, WHISPER_SAMPLE_RATE);
+        }
+    }
+    return segments;
+}
+
+const std::vector<uint8_t> & export_result(TranscriptionResult & result) {
+    if (result.exported.empty()) {
+        serialize_transcript(result_segments(result), result.exported);
+    }
+    return result.exported;
+}
+
+} // namespace memex
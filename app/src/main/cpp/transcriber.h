@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cancel.h"
+#include "cascade.h"
+#include "grammar.h"
+#include "longform.h"
+#include "model_registry.h"
+#include "speculative.h"
+#include "state_pool.h"
+#include "transcript.h"
+#include "transcription_listener.h"
+#include "vad.h"
+
+namespace memex {
+
+// Silence inserted between VAD segments when they are stitched together
+constexpr int kSpeechGapMs = 100;
+
+// Command grammar installed on a transcriber, swapped atomically so a decode
+// in flight keeps the grammar it started with.
+struct CommandGrammar {
+    Grammar grammar;
+    float penalty = 100.0f;
+};
+
+// Silence trimming before decoding. Installed on a transcriber as a whole
+// and swapped atomically, so a request sees one consistent setting.
+struct VadSettings {
+    bool enabled = false;
+    VadParams params;
+};
+
+// One client's model and request options: a WhisperService instance on
+// Android (handed to Kotlin as a jlong) or a memex-cli run. Each holds one
+// reference to a registry model, so several transcribers share a single
+// copy of the weights.
+struct Transcriber {
+    std::shared_ptr<Model> model;
+
+    // Trim silence with the VAD before decoding; never null, access with
+    // std::atomic_load/store
+    std::shared_ptr<const VadSettings> vad = std::make_shared<const VadSettings>();
+
+    // Grammar for profiles with use_grammar; access with std::atomic_load/store
+    std::shared_ptr<const CommandGrammar> grammar;
+
+    // Receives segments and progress while decoding; std::atomic_load/store
+    std::shared_ptr<const TranscriptionListener> listener;
+
+    // Larger model to escalate low-confidence transcripts to; std::atomic_load/store
+    std::shared_ptr<const Cascade> cascade;
+    CascadeStats cascade_stats;
+
+    // Smaller model drafting tokens for speculative decoding; std::atomic_load/store
+    std::shared_ptr<Model> draft;
+};
+
+// Results of one transcription request. It keeps the decoder state the
+// request ran on leased until it is destroyed, so results of concurrent
+// requests on the same model never overwrite each other.
+struct TranscriptionResult {
+    std::shared_ptr<Model> model;
+    StateLease lease;              // empty when the VAD found no speech
+
+    // Speech segments the decode ran on when the VAD pre-filter was used, for
+    // mapping result timestamps back onto the original clip
+    std::vector<SpeechSegment> speech;
+
+    // Long-form results are stitched from several states, so they are copied
+    // out and no state stays leased
+    std::vector<TranscriptSegment> segments;
+    std::vector<ChunkStats> chunks;
+
+    // Draft acceptance of a speculative decode
+    SpeculativeStats speculative;
+
+    // Encoder context the decode ran with (0 = full window), its measured
+    // encoder time summed over the clip's 30 s windows and the estimated
+    // saving over a full window
+    int audio_ctx = 0;
+    double encode_ms = 0.0;
+    double encode_saved_ms = 0.0;
+
+    // Mel spectrogram time and whole whisper_full call of the last decode;
+    // the decoder took the rest (see decode_ms())
+    double mel_ms = 0.0;
+    double full_ms = 0.0;
+
+    double decode_ms() const { return std::max(0.0, full_ms - mel_ms - encode_ms); }
+
+    // Request id of the result's spans in the trace buffer (see trace.h)
+    uint64_t trace_id = 0;
+
+    // Serialised transcript, built on first export
+    std::vector<uint8_t> exported;
+};
+
+// Acquire a registry model from a file path, loading it on first use.
+std::shared_ptr<Model> acquire_model_file(const std::string & model_path);
+
+// Transcriber for `model`, or nullptr if it is null. Parks one compute
+// worker per decoder state up front.
+std::unique_ptr<Transcriber> make_transcriber(std::shared_ptr<Model> model);
+
+// Transcribe `samples` (16 kHz mono) with decode profile `profile_id`,
+// applying the transcriber's request options. With a cascade set, a
+// transcript whose confidence is below the cascade threshold is re-decoded
+// with the cascade's larger model, and the listener receives only the
+// segments of the transcript that is kept, once the cascade has decided.
+// `cancel` (may be null) stops the request once cancelled or past its
+// deadline. Returns nullptr on failure or cancellation.
+std::unique_ptr<TranscriptionResult> transcribe(Transcriber & transcriber,
+                                                int n_threads,
+                                                int profile_id,
+                                                const float * samples,
+                                                int n_samples,
+                                                CancelToken * cancel);
+
+// Long-form transcription over VAD chunks (see longform.h), decoded by up
+// to `params.n_workers` states in parallel. The transcriber's VAD settings
+// and listener are used; the segments and chunk stats are copied into the
+// result.
+std::unique_ptr<TranscriptionResult> transcribe_long_form(Transcriber & transcriber,
+                                                          LongFormParams params,
+                                                          const float * samples,
+                                                          size_t n_samples,
+                                                          CancelToken * cancel);
+
+// Speculative transcription of one clip with the transcriber's draft model
+// (see speculative.h). Fails if no draft model is set; if none of the draft
+// model's decoder states is free, the clip is decoded with the default
+// profile without a draft instead.
+std::unique_ptr<TranscriptionResult> transcribe_with_draft(Transcriber & transcriber,
+                                                           const SpeculativeParams & params,
+                                                           const float * samples,
+                                                           int n_samples,
+                                                           CancelToken * cancel);
+
+// Wall time of one whisper_full call on `samples` with `n_threads` threads,
+// in milliseconds, averaged over `iterations` decodes on one of the model's
+// decoder states. `spawned_ms` starts a fresh thread per call, so ggml's
+// OpenMP team is started for every decode as it would be on a short-lived
+// caller thread. `pooled_ms` runs on a parked ComputePool worker, whose team
+// is reused; its first decode warms the worker and is not counted. Both are
+// -1 if no decode succeeded.
+struct ThreadStartupCost {
+    int n_threads = 0;
+    double spawned_ms = -1.0;
+    double pooled_ms = -1.0;
+};
+
+ThreadStartupCost measure_thread_startup(Model & model,
+                                         int n_threads,
+                                         int iterations,
+                                         const float * samples,
+                                         int n_samples);
+
+// The result's segments with times on the submitted clip.
+std::vector<TranscriptSegment> result_segments(const TranscriptionResult & result);
+
+// The result's transcript in the layout of serialize_transcript. Built once
+// and cached on the result.
+const std::vector<uint8_t> & export_result(TranscriptionResult & result);
+
+} // namespace memex
@@ -0,0 +1,131 @@
+#include "transcript.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace memex {
+
+namespace {
+
+const int32_t kTranscriptVersion = 1;
+
+template <typename T>
+void put(std::vector<uint8_t> & out, T value) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+void put_at(std::vector<uint8_t> & out, size_t at, T value) {
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+} // namespace
+
+TranscriptSegment segment_from_state(struct whisper_context * ctx, struct whisper_state * state, int i) {
+    TranscriptSegment seg;
+
+    // Segment times are in 10 ms units
+    seg.t0_ms = whisper_full_get_segment_t0_from_state(state, i) * 10;
+    seg.t1_ms = whisper_full_get_segment_t1_from_state(state, i) * 10;
+    const char * text = whisper_full_get_segment_text_from_state(state, i);
+    seg.text = text ? text : "";
+    seg.no_speech_prob = whisper_full_get_segment_no_speech_prob_from_state(state, i);
+
+    // Tokens at or above end-of-text are specials and timestamps
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+    seg.tokens.reserve(n_tokens);
+    double sum_logprob = 0.0;
+    for (int j = 0; j < n_tokens; ++j) {
+        const whisper_token_data data = whisper_full_get_token_data_from_state(state, i, j);
+        if (data.id >= eot) {
+            continue;
+        }
+        seg.tokens.push_back({data.id, data.p, data.plog});
+        sum_logprob += data.plog;
+    }
+    seg.avg_logprob = seg.tokens.empty() ? 0.0f : (float) (sum_logprob / seg.tokens.size());
+    return seg;
+}
+
+std::vector<TranscriptSegment> segments_from_state(struct whisper_context * ctx, struct whisper_state * state) {
+    std::vector<TranscriptSegment> segments;
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    segments.reserve(n_segments);
+    for (int i = 0; i < n_segments; ++i) {
+        segments.push_back(segment_from_state(ctx, state, i));
+    }
+    return segments;
+}
+
+float transcript_confidence(const std::vector<TranscriptSegment> & segments) {
+    size_t n_tokens = 0;
+    double sum_logprob = 0.0;
+    float no_speech_prob = 0.0f;
+    for (const TranscriptSegment & seg : segments) {
+        n_tokens += seg.tokens.size();
+        sum_logprob += (double) seg.avg_logprob * seg.tokens.size();
+        no_speech_prob = std::max(no_speech_prob, seg.no_speech_prob);
+    }
+    if (n_tokens == 0) {
+        return 0.0f;
+    }
+    return (float) std::exp(sum_logprob / n_tokens) * (1.0f - no_speech_prob);
+}
+
+std::string transcript_text(const std::vector<TranscriptSegment> & segments) {
+    std::string text;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (i > 0) {
+            text += ' ';
+        }
+        text += segments[i].text;
+    }
+    return text;
+}
+
+void serialize_transcript(const std::vector<TranscriptSegment> & segments, std::vector<uint8_t> & out) {
+    size_t n_bytes = 16 + 4 * segments.size();
+    size_t n_tokens_total = 0;
+    double sum_logprob = 0.0;
+    float no_speech_prob = 0.0f;
+    for (const TranscriptSegment & seg : segments) {
+        n_bytes += 32 + 8 * seg.tokens.size() + ((seg.text.size() + 3) & ~(size_t) 3);
+        n_tokens_total += seg.tokens.size();
+        sum_logprob += (double) seg.avg_logprob * seg.tokens.size();
+        no_speech_prob = std::max(no_speech_prob, seg.no_speech_prob);
+    }
+
+    out.clear();
+    out.reserve(n_bytes);
+    put<int32_t>(out, kTranscriptVersion);
+    put<int32_t>(out, (int32_t) segments.size());
+    put<float>(out, n_tokens_total > 0 ? (float) (sum_logprob / n_tokens_total) : 0.0f);
+    put<float>(out, no_speech_prob);
+
+    const size_t offsets_at = out.size();
+    out.resize(out.size() + 4 * segments.size());
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const TranscriptSegment & seg = segments[i];
+        put_at<int32_t>(out, offsets_at + 4 * i, (int32_t) out.size());
+
+        put<int64_t>(out, seg.t0_ms);
+        put<int64_t>(out, seg.t1_ms);
+        put<float>(out, seg.avg_logprob);
+        put<float>(out, seg.no_speech_prob);
+        put<int32_t>(out, (int32_t) seg.tokens.size());
+        put<int32_t>(out, (int32_t) seg.text.size());
+        for (const TokenProb & token : seg.tokens) {
+            put<int32_t>(out, token.id);
+            put<float>(out, token.p);
+        }
+        out.insert(out.end(), seg.text.begin(), seg.text.end());
+        out.resize((out.size() + 3) & ~(size_t) 3, 0);
+    }
+}
+
+} // namespace memex
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "whisper.h"
+
+namespace memex {
+
+struct TokenProb {
+    int32_t id = 0;
+    float p = 0.0f;     // probability of the sampled token
+    float plog = 0.0f;  // its log probability
+};
+
+struct TranscriptSegment {
+    int64_t t0_ms = 0;
+    int64_t t1_ms = 0;
+    std::string text;
+    std::vector<TokenProb> tokens;  // text tokens only, no timestamps or specials
+    float avg_logprob = 0.0f;       // mean plog over `tokens`
+    float no_speech_prob = 0.0f;
+};
+
+// Copy segment `i` of a finished decode out of `state`, with times in
+// milliseconds of the decoded audio.
+TranscriptSegment segment_from_state(struct whisper_context * ctx, struct whisper_state * state, int i);
+
+// All segments of a finished decode, as segment_from_state().
+std::vector<TranscriptSegment> segments_from_state(struct whisper_context * ctx, struct whisper_state * state);
+
+// Confidence in a transcript, in [0, 1]: the geometric mean of its text token
+// probabilities times the probability that the audio held speech (1 minus
+// the highest segment no-speech probability). 0 when there are no tokens.
+float transcript_confidence(const std::vector<TranscriptSegment> & segments);
+
+// Segment texts joined with single spaces.
+std::string transcript_text(const std::vector<TranscriptSegment> & segments);
+
+// Serialise segments into `out` (native byte order, 4-byte aligned records):
+//
+//   header   int32 version (1), int32 n_segments,
+//            float avg_logprob, float no_speech_prob   over the whole transcript
+//   offsets  int32[n_segments]                         byte offset of each record
+//   record   int64 t0_ms, int64 t1_ms, float avg_logprob, float no_speech_prob,
+//            int32 n_tokens, int32 text_bytes,
+//            { int32 id, float p }[n_tokens], UTF-8 text, zero padding to 4 bytes
+//
+// The transcript avg_logprob is the mean over all text tokens (0 when there
+// are none); no_speech_prob is the highest segment value.
+void serialize_transcript(const std::vector<TranscriptSegment> & segments, std::vector<uint8_t> & out);
+
+} // namespace memex
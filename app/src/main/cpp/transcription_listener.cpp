@@ -0,0 +1,71 @@
+#include "transcription_listener.h"
+
+namespace memex {
+
+SegmentForwarder::SegmentForwarder(std::shared_ptr<const TranscriptionListener> listener,
+                                   const std::vector<SpeechSegment> * speech,
+                                   int gap_ms, int sample_rate)
+    : listener_(std::move(listener)), speech_(speech), gap_ms_(gap_ms), sample_rate_(sample_rate) {}
+
+void SegmentForwarder::attach(whisper_full_params & wparams) {
+    prev_new_segment_      = wparams.new_segment_callback;
+    prev_new_segment_data_ = wparams.new_segment_callback_user_data;
+    prev_progress_         = wparams.progress_callback;
+    prev_progress_data_    = wparams.progress_callback_user_data;
+
+    wparams.new_segment_callback           = on_new_segment;
+    wparams.new_segment_callback_user_data = this;
+    wparams.progress_callback              = on_progress;
+    wparams.progress_callback_user_data    = this;
+}
+
+int64_t SegmentForwarder::source_ms(int64_t t_ms) const {
+    if (speech_ == nullptr || speech_->empty()) {
+        return t_ms;
+    }
+    return gathered_to_source_ms(t_ms, *speech_, gap_ms_, sample_rate_);
+}
+
+void SegmentForwarder::forward_segments(struct whisper_state * state, int first, int end) const {
+    // Segment times are in 10 ms units
+    for (int i = first; i < end; ++i) {
+        listener_->on_segment(i,
+                              source_ms(whisper_full_get_segment_t0_from_state(state, i) * 10),
+                              source_ms(whisper_full_get_segment_t1_from_state(state, i) * 10),
+                              whisper_full_get_segment_text_from_state(state, i));
+    }
+}
+
+void SegmentForwarder::replay(struct whisper_state * state) {
+    forward_segments(state, 0, whisper_full_n_segments_from_state(state));
+    if (last_progress_ != 100) {
+        last_progress_ = 100;
+        listener_->on_progress(100);
+    }
+}
+
+void SegmentForwarder::on_new_segment(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data) {
+    SegmentForwarder * self = static_cast<SegmentForwarder *>(user_data);
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    self->forward_segments(state, n_segments - n_new, n_segments);
+
+    if (self->prev_new_segment_ != nullptr) {
+        self->prev_new_segment_(ctx, state, n_new, self->prev_new_segment_data_);
+    }
+}
+
+void SegmentForwarder::on_progress(struct whisper_context * ctx, struct whisper_state * state, int progress, void * user_data) {
+    SegmentForwarder * self = static_cast<SegmentForwarder *>(user_data);
+
+    if (progress != self->last_progress_) {
+        self->last_progress_ = progress;
+        self->listener_->on_progress(progress);
+    }
+
+    if (self->prev_progress_ != nullptr) {
+        self->prev_progress_(ctx, state, progress, self->prev_progress_data_);
+    }
+}
+
+} // namespace memex
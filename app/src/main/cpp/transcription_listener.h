@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "vad.h"
+#include "whisper.h"
+
+namespace memex {
+
+// Receives partial results of a decode: each segment as it is decoded and
+// progress in percent. Calls are made on whatever thread produces the
+// result. The JNI build forwards them to a Kotlin listener
+// (java_listener.h).
+class TranscriptionListener {
+public:
+    TranscriptionListener() = default;
+    virtual ~TranscriptionListener() = default;
+
+    TranscriptionListener(const TranscriptionListener &) = delete;
+    TranscriptionListener & operator=(const TranscriptionListener &) = delete;
+
+    virtual void on_segment(int index, int64_t t0_ms, int64_t t1_ms, const char * text) const = 0;
+    virtual void on_progress(int percent) const = 0;
+};
+
+// Per-request bridge from whisper's new_segment and progress callbacks to a
+// listener. Segment times are reported in milliseconds of the audio the
+// caller submitted: when the decode ran on VAD-gathered speech, they are
+// mapped back through the speech segments.
+class SegmentForwarder {
+public:
+    SegmentForwarder(std::shared_ptr<const TranscriptionListener> listener,
+                     const std::vector<SpeechSegment> * speech = nullptr,
+                     int gap_ms = 0, int sample_rate = 16000);
+
+    // Point the callbacks of `wparams` at this forwarder, chaining to any
+    // already set. The forwarder must outlive the decode.
+    void attach(whisper_full_params & wparams);
+
+    // Forward every segment of a finished decode in `state` that ran without
+    // the forwarder attached, then report it complete.
+    void replay(struct whisper_state * state);
+
+private:
+    static void on_new_segment(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data);
+    static void on_progress(struct whisper_context * ctx, struct whisper_state * state, int progress, void * user_data);
+
+    int64_t source_ms(int64_t t_ms) const;
+
+    // Pass segments [first, end) of `state` to the listener
+    void forward_segments(struct whisper_state * state, int first, int end) const;
+
+    std::shared_ptr<const TranscriptionListener> listener_;
+    const std::vector<SpeechSegment> * speech_;
+    int gap_ms_;
+    int sample_rate_;
+    int last_progress_ = -1;
+
+    whisper_new_segment_callback prev_new_segment_ = nullptr;
+    void * prev_new_segment_data_ = nullptr;
+    whisper_progress_callback prev_progress_ = nullptr;
+    void * prev_progress_data_ = nullptr;
+};
+
+} // namespace memex
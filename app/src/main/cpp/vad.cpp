@@ -0,0 +1,250 @@
+#include "vad.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace memex {
+
+namespace {
+
+// In-place iterative radix-2 complex FFT; n must be a power of two
+void fft(float * re, float * im, int n) {
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        const float ang = -2.0f * (float) M_PI / len;
+        const float wr = std::cos(ang);
+        const float wi = std::sin(ang);
+        for (int i = 0; i < n; i += len) {
+            float cr = 1.0f;
+            float ci = 0.0f;
+            for (int k = 0; k < len / 2; ++k) {
+                const int a = i + k;
+                const int b = a + len / 2;
+                const float tr = re[b] * cr - im[b] * ci;
+                const float ti = re[b] * ci + im[b] * cr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+                const float ncr = cr * wr - ci * wi;
+                ci = cr * wi + ci * wr;
+                cr = ncr;
+            }
+        }
+    }
+}
+
+int next_pow2(int n) {
+    int p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+} // namespace
+
+VoiceActivityDetector::VoiceActivityDetector(const VadParams & params)
+    : params_(params) {
+    frame_size_ = std::max(1, params_.sample_rate * params_.frame_ms / 1000);
+    n_fft_ = next_pow2(frame_size_);
+
+    // Speech band used for the flatness measure
+    bin_lo_ = std::max(1, (int) (100.0f * n_fft_ / params_.sample_rate));
+    bin_hi_ = std::min(n_fft_ / 2, (int) (4000.0f * n_fft_ / params_.sample_rate));
+
+    const float rc = 1.0f / (2.0f * (float) M_PI * 100.0f);
+    const float dt = 1.0f / params_.sample_rate;
+    hp_alpha_ = rc / (rc + dt);
+
+    window_.resize(frame_size_);
+    for (int i = 0; i < frame_size_; ++i) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * (float) M_PI * i / std::max(1, frame_size_ - 1));
+    }
+    frame_.resize(frame_size_);
+    re_.resize(n_fft_);
+    im_.resize(n_fft_);
+
+    reset();
+}
+
+void VoiceActivityDetector::reset() {
+    hp_prev_in_ = 0.0f;
+    hp_prev_out_ = 0.0f;
+    noise_db_ = params_.min_energy_db;
+    n_frames_ = 0;
+    pending_.clear();
+}
+
+void VoiceActivityDetector::process(const float * samples, size_t n, std::vector<uint8_t> & decisions) {
+    size_t pos = 0;
+
+    // Complete a frame left over from the previous call
+    if (!pending_.empty()) {
+        const size_t n_fill = std::min(n, (size_t) frame_size_ - pending_.size());
+        pending_.insert(pending_.end(), samples, samples + n_fill);
+        pos = n_fill;
+        if ((int) pending_.size() == frame_size_) {
+            decisions.push_back(classify_frame(pending_.data()) ? 1 : 0);
+            pending_.clear();
+        }
+    }
+
+    for (; pos + frame_size_ <= n; pos += frame_size_) {
+        decisions.push_back(classify_frame(samples + pos) ? 1 : 0);
+    }
+
+    pending_.insert(pending_.end(), samples + pos, samples + n);
+}
+
+bool VoiceActivityDetector::classify_frame(const float * frame) {
+    // High-pass to remove DC and rumble, then measure energy
+    double energy = 0.0;
+    for (int i = 0; i < frame_size_; ++i) {
+        const float y = hp_alpha_ * (hp_prev_out_ + frame[i] - hp_prev_in_);
+        hp_prev_in_ = frame[i];
+        hp_prev_out_ = y;
+        frame_[i] = y;
+        energy += (double) y * y;
+    }
+    const float energy_db = 10.0f * std::log10((float) (energy / frame_size_) + 1e-10f);
+
+    // Spectral flatness over the speech band
+    std::fill(re_.begin(), re_.end(), 0.0f);
+    std::fill(im_.begin(), im_.end(), 0.0f);
+    for (int i = 0; i < frame_size_; ++i) {
+        re_[i] = frame_[i] * window_[i];
+    }
+    fft(re_.data(), im_.data(), n_fft_);
+
+    double log_sum = 0.0;
+    double lin_sum = 0.0;
+    for (int k = bin_lo_; k < bin_hi_; ++k) {
+        const double p = (double) re_[k] * re_[k] + (double) im_[k] * im_[k] + 1e-12;
+        log_sum += std::log(p);
+        lin_sum += p;
+    }
+    const int n_bins = std::max(1, bin_hi_ - bin_lo_);
+    const float flatness = (float) (std::exp(log_sum / n_bins) / (lin_sum / n_bins));
+
+    // Noise floor: follow quiet frames down immediately, creep up slowly so a
+    // long utterance does not become the new floor
+    if (n_frames_ == 0 || energy_db < noise_db_) {
+        noise_db_ = std::max(energy_db, params_.min_energy_db - 20.0f);
+    } else {
+        noise_db_ += 0.005f * (energy_db - noise_db_);
+    }
+    ++n_frames_;
+
+    const float threshold_db = std::max(noise_db_ + params_.energy_margin_db, params_.min_energy_db);
+    return energy_db > threshold_db && flatness < params_.max_flatness;
+}
+
+std::vector<SpeechSegment> decisions_to_segments(const std::vector<uint8_t> & decisions,
+                                                 int frame_size, size_t n_samples,
+                                                 const VadParams & params) {
+    const int ms_per_frame = std::max(1, params.frame_ms);
+    const int min_speech_frames  = std::max(1, params.min_speech_ms / ms_per_frame);
+    const int min_silence_frames = std::max(1, params.min_silence_ms / ms_per_frame);
+    const int64_t pad = (int64_t) params.pad_ms * params.sample_rate / 1000;
+
+    // Raw runs of speech frames, with short pauses bridged
+    std::vector<SpeechSegment> runs;
+    int run_start = -1;
+    int last_speech = -1;
+    for (int i = 0; i < (int) decisions.size(); ++i) {
+        if (!decisions[i]) {
+            continue;
+        }
+        if (run_start >= 0 && i - last_speech > min_silence_frames) {
+            runs.push_back({(int64_t) run_start * frame_size, (int64_t) (last_speech + 1) * frame_size});
+            run_start = -1;
+        }
+        if (run_start < 0) {
+            run_start = i;
+        }
+        last_speech = i;
+    }
+    if (run_start >= 0) {
+        runs.push_back({(int64_t) run_start * frame_size, (int64_t) (last_speech + 1) * frame_size});
+    }
+
+    // Drop blips, pad, and merge segments the padding made overlap
+    std::vector<SpeechSegment> segments;
+    for (const SpeechSegment & run : runs) {
+        if (run.length() < (int64_t) min_speech_frames * frame_size) {
+            continue;
+        }
+        SpeechSegment seg;
+        seg.start = std::max<int64_t>(0, run.start - pad);
+        seg.end = std::min<int64_t>((int64_t) n_samples, run.end + pad);
+        if (!segments.empty() && seg.start <= segments.back().end) {
+            segments.back().end = std::max(segments.back().end, seg.end);
+        } else {
+            segments.push_back(seg);
+        }
+    }
+    return segments;
+}
+
+std::vector<SpeechSegment> detect_speech(const float * samples, size_t n, const VadParams & params) {
+    VoiceActivityDetector vad(params);
+    std::vector<uint8_t> decisions;
+    decisions.reserve(n / vad.frame_size() + 1);
+    vad.process(samples, n, decisions);
+    return decisions_to_segments(decisions, vad.frame_size(), n, params);
+}
+
+size_t gather_speech(const float * samples, const std::vector<SpeechSegment> & segments,
+                     int gap_ms, int sample_rate, std::vector<float> & out) {
+    const size_t gap = (size_t) gap_ms * sample_rate / 1000;
+
+    size_t total = 0;
+    for (const SpeechSegment & seg : segments) {
+        total += (size_t) seg.length();
+    }
+
+    out.clear();
+    out.reserve(total + gap * (segments.empty() ? 0 : segments.size() - 1));
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (i > 0) {
+            out.insert(out.end(), gap, 0.0f);
+        }
+        out.insert(out.end(), samples + segments[i].start, samples + segments[i].end);
+    }
+    return total;
+}
+
+int64_t gathered_to_source_ms(int64_t t_ms, const std::vector<SpeechSegment> & segments,
+                              int gap_ms, int sample_rate) {
+    const int64_t t = t_ms * sample_rate / 1000;
+    const int64_t gap = (int64_t) gap_ms * sample_rate / 1000;
+
+    int64_t offset = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const int64_t len = segments[i].length();
+        if (t < offset + len || i + 1 == segments.size()) {
+            const int64_t within = std::min(std::max<int64_t>(0, t - offset), len);
+            return (segments[i].start + within) * 1000 / sample_rate;
+        }
+        offset += len + gap;
+        // Times inside a gap snap to the start of the next segment
+        if (t < offset) {
+            return segments[i + 1].start * 1000 / sample_rate;
+        }
+    }
+    return t_ms;
+}
+
+} // namespace memex
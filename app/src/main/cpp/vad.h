@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace memex {
+
+struct VadParams {
+    int   sample_rate     = 16000;
+    int   frame_ms        = 20;     // analysis frame length (non-overlapping)
+    float energy_margin_db = 9.0f;  // required rise above the tracked noise floor
+    float min_energy_db   = -55.0f; // absolute floor; quieter frames are never speech
+    float max_flatness    = 0.55f;  // spectral flatness above this looks like noise
+    int   min_speech_ms   = 120;    // shorter bursts are dropped
+    int   min_silence_ms  = 300;    // shorter pauses do not split a segment
+    int   pad_ms          = 150;    // context kept on each side of a segment
+};
+
+// A span of speech in samples, [start, end).
+struct SpeechSegment {
+    int64_t start = 0;
+    int64_t end = 0;
+
+    int64_t length() const { return end - start; }
+};
+
+// Frame classifier combining high-passed log energy against an adaptive noise
+// floor with spectral flatness (speech is far less flat than fan, road or
+// hiss noise of the same loudness). Usable incrementally: feed frames in
+// order and it keeps its noise estimate across calls.
+class VoiceActivityDetector {
+public:
+    explicit VoiceActivityDetector(const VadParams & params = VadParams());
+
+    // Classify `n` samples (any length); returns one decision per complete
+    // frame. Leftover samples are buffered for the next call.
+    void process(const float * samples, size_t n, std::vector<uint8_t> & decisions);
+
+    int frame_size() const { return frame_size_; }
+    float noise_floor_db() const { return noise_db_; }
+    const VadParams & params() const { return params_; }
+
+    void reset();
+
+private:
+    bool classify_frame(const float * frame);
+
+    VadParams params_;
+    int frame_size_;
+    int n_fft_;
+    int bin_lo_;
+    int bin_hi_;
+
+    // High-pass filter state (first-order, ~100 Hz) carried across frames
+    float hp_prev_in_ = 0.0f;
+    float hp_prev_out_ = 0.0f;
+    float hp_alpha_;
+
+    float noise_db_;
+    int n_frames_ = 0;
+
+    std::vector<float> pending_;
+    std::vector<float> frame_;
+    std::vector<float> window_;
+    std::vector<float> re_;
+    std::vector<float> im_;
+};
+
+// Run VAD over a whole clip and return padded, merged speech segments.
+std::vector<SpeechSegment> detect_speech(const float * samples, size_t n, const VadParams & params = VadParams());
+
+// Turn per-frame decisions into speech segments, applying the minimum speech
+// and silence durations and padding. `n_samples` clamps the last segment.
+std::vector<SpeechSegment> decisions_to_segments(const std::vector<uint8_t> & decisions,
+                                                 int frame_size, size_t n_samples,
+                                                 const VadParams & params);
+
+// Concatenate the speech segments of `samples` into `out`, separated by
+// `gap_ms` of silence. Returns the total speech length in samples.
+size_t gather_speech(const float * samples, const std::vector<SpeechSegment> & segments,
+                     int gap_ms, int sample_rate, std::vector<float> & out);
+
+// Map a time in a gather_speech() buffer back to the original clip.
+int64_t gathered_to_source_ms(int64_t t_ms, const std::vector<SpeechSegment> & segments,
+                              int gap_ms, int sample_rate);
+
+} // namespace memex
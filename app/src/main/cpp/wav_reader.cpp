@@ -0,0 +1,206 @@
+#include "wav_reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "log.h"
+#include "pcm_convert.h"
+
+namespace memex {
+
+namespace {
+
+uint16_t read_u16(const uint8_t * p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+uint32_t read_u32(const uint8_t * p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+bool chunk_id_is(const uint8_t * p, const char * id) {
+    return memcmp(p, id, 4) == 0;
+}
+
+} // namespace
+
+bool parse_wav(const uint8_t * data, size_t size, WavInfo & info, std::string & error) {
+    info = WavInfo();
+
+    if (size < 12 || !chunk_id_is(data, "RIFF") || !chunk_id_is(data + 8, "WAVE")) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+
+    bool have_fmt = false;
+    bool have_data = false;
+    size_t pos = 12;
+
+    while (pos + 8 <= size && !have_data) {
+        const uint8_t * chunk = data + pos;
+        const size_t chunk_size = read_u32(chunk + 4);
+        const size_t body = pos + 8;
+
+        if (chunk_id_is(chunk, "fmt ")) {
+            if (chunk_size < 16 || body + chunk_size > size) {
+                error = "truncated fmt chunk";
+                return false;
+            }
+            info.format          = read_u16(data + body);
+            info.n_channels      = read_u16(data + body + 2);
+            info.sample_rate     = read_u32(data + body + 4);
+            info.block_align     = read_u16(data + body + 12);
+            info.bits_per_sample = read_u16(data + body + 14);
+
+            if (info.format == WAV_FORMAT_EXTENSIBLE) {
+                // cbSize(2) validBits(2) channelMask(4) then the SubFormat GUID,
+                // whose first two bytes are the real format code
+                if (chunk_size < 40) {
+                    error = "truncated WAVE_FORMAT_EXTENSIBLE fmt chunk";
+                    return false;
+                }
+                info.format = read_u16(data + body + 24);
+            }
+            have_fmt = true;
+        } else if (chunk_id_is(chunk, "data")) {
+            if (!have_fmt) {
+                error = "data chunk before fmt chunk";
+                return false;
+            }
+            info.data_offset = body;
+            // Streaming writers leave the size as 0 or 0xFFFFFFFF; trust the file
+            const size_t available = size > body ? size - body : 0;
+            info.data_size = (chunk_size == 0 || chunk_size > available) ? available : chunk_size;
+            have_data = true;
+        }
+
+        // Chunks are word aligned; odd sizes carry a pad byte
+        pos = body + chunk_size + (chunk_size & 1);
+    }
+
+    if (!have_fmt) {
+        error = "missing fmt chunk";
+        return false;
+    }
+    if (!have_data) {
+        error = "missing data chunk";
+        return false;
+    }
+    if (info.n_channels == 0 || info.block_align == 0) {
+        error = "invalid channel count or block alignment";
+        return false;
+    }
+
+    const bool pcm_ok = info.format == WAV_FORMAT_PCM &&
+        (info.bits_per_sample == 8 || info.bits_per_sample == 16 ||
+         info.bits_per_sample == 24 || info.bits_per_sample == 32);
+    const bool float_ok = info.format == WAV_FORMAT_IEEE_FLOAT &&
+        (info.bits_per_sample == 32 || info.bits_per_sample == 64);
+    if (!pcm_ok && !float_ok) {
+        error = "unsupported sample format " + std::to_string(info.format) +
+                " / " + std::to_string(info.bits_per_sample) + " bits";
+        return false;
+    }
+    if (info.block_align != info.n_channels * (info.bits_per_sample / 8)) {
+        error = "block alignment does not match channels and sample size";
+        return false;
+    }
+
+    return true;
+}
+
+bool decode_wav_samples(const uint8_t * data, const WavInfo & info, std::vector<float> & pcmf32) {
+    const size_t n_frames = info.n_frames();
+    const size_t n_samples = n_frames * info.n_channels;
+    const uint8_t * src = data + info.data_offset;
+
+    // Decode interleaved samples, then fold channels down in place
+    pcmf32.resize(n_samples);
+    float * dst = pcmf32.data();
+
+    switch (info.bits_per_sample) {
+        case 8:
+            pcm_u8_to_f32(src, dst, n_samples);
+            break;
+        case 16:
+            pcm_s16le_bytes_to_f32(src, dst, n_samples);
+            break;
+        case 24:
+            pcm_s24_to_f32(src, dst, n_samples);
+            break;
+        case 32:
+            if (info.format == WAV_FORMAT_IEEE_FLOAT) {
+                memcpy(dst, src, n_samples * sizeof(float));
+            } else {
+                pcm_s32_to_f32(src, dst, n_samples);
+            }
+            break;
+        case 64:
+            pcm_f64_to_f32(src, dst, n_samples);
+            break;
+        default:
+            pcmf32.clear();
+            return false;
+    }
+
+    if (info.n_channels > 1) {
+        downmix_to_mono(dst, dst, n_frames, info.n_channels);
+        pcmf32.resize(n_frames);
+    }
+
+    return true;
+}
+
+std::vector<float> read_wav(const std::string & fname, WavInfo * info_out) {
+    std::vector<float> pcmf32;
+
+    int fd = open(fname.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Failed to open audio file: %s", fname.c_str());
+        return pcmf32;
+    }
+
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        LOGE("Failed to stat audio file: %s", fname.c_str());
+        close(fd);
+        return pcmf32;
+    }
+
+    const size_t size = (size_t) st.st_size;
+    void * mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapped == MAP_FAILED) {
+        LOGE("Failed to map audio file: %s (%s)", fname.c_str(), strerror(errno));
+        return pcmf32;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    const uint8_t * data = static_cast<const uint8_t *>(mapped);
+    WavInfo info;
+    std::string error;
+
+    if (!parse_wav(data, size, info, error)) {
+        LOGE("Invalid WAV file %s: %s", fname.c_str(), error.c_str());
+    } else if (!decode_wav_samples(data, info, pcmf32)) {
+        LOGE("Failed to decode WAV samples: %s", fname.c_str());
+    } else {
+        if (info.sample_rate != 16000) {
+            LOGW("WAV sample rate is %u Hz, Whisper expects 16000 Hz", info.sample_rate);
+        }
+        if (info_out != nullptr) {
+            *info_out = info;
+        }
+        LOGI("Read %zu samples from %s (%u ch, %u bit, %u Hz)",
+             pcmf32.size(), fname.c_str(), info.n_channels, info.bits_per_sample, info.sample_rate);
+    }
+
+    munmap(mapped, size);
+    return pcmf32;
+}
+
+} // namespace memex
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memex {
+
+enum WavFormat : uint16_t {
+    WAV_FORMAT_PCM        = 0x0001,
+    WAV_FORMAT_IEEE_FLOAT = 0x0003,
+    WAV_FORMAT_EXTENSIBLE = 0xFFFE,
+};
+
+struct WavInfo {
+    uint16_t format = 0;          // PCM or IEEE float after resolving EXTENSIBLE
+    uint16_t n_channels = 0;
+    uint32_t sample_rate = 0;
+    uint16_t bits_per_sample = 0;
+    uint16_t block_align = 0;
+    size_t data_offset = 0;       // byte offset of the first sample
+    size_t data_size = 0;         // bytes of sample data actually present
+
+    size_t n_frames() const { return block_align ? data_size / block_align : 0; }
+};
+
+// Walk the RIFF chunks of a WAV image (fmt, data; LIST and anything else is
+// skipped). Handles WAVE_FORMAT_EXTENSIBLE and data chunks whose declared
+// size overruns the file, as written by streaming recorders.
+bool parse_wav(const uint8_t * data, size_t size, WavInfo & info, std::string & error);
+
+// Convert the samples described by `info` to mono float.
+bool decode_wav_samples(const uint8_t * data, const WavInfo & info, std::vector<float> & pcmf32);
+
+// Map `fname`, parse it and decode it to mono float in one pass. Accepts 8-,
+// 16-, 24- and 32-bit integer PCM and 32/64-bit float PCM with any channel
+// count. Returns an empty vector on failure.
+std::vector<float> read_wav(const std::string & fname, WavInfo * info_out = nullptr);
+
+} // namespace memex
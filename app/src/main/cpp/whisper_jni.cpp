@@ -1,20 +1,109 @@
 #include <jni.h>
+#include <algorithm>
 #include <string>
 #include <android/log.h>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
 #include <vector>
-#include <sstream>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <memory>
 #include "whisper.h"
+#include "asset_loader.h"
+#include "cancel.h"
+#include "cascade.h"
+#include "cpu_backend.h"
+#include "cpu_topology.h"
+#include "decode_profile.h"
+#include "grammar.h"
+#include "java_listener.h"
+#include "log.h"
+#include "longform.h"
+#include "memory_stats.h"
+#include "model_loader.h"
+#include "model_registry.h"
+#include "pcm_convert.h"
+#include "ring_buffer.h"
+#include "streaming.h"
+#include "transcriber.h"
+#include "trace.h"
+#include "transcript.h"
+#include "vad.h"
+#include "wav_reader.h"
 
-#define LOG_TAG "WhisperJNI"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+static memex::Transcriber * handle_from_jlong(jlong contextPtr) {
+    return reinterpret_cast<memex::Transcriber *>(contextPtr);
+}
+
+static memex::TranscriptionResult * result_from_jlong(jlong resultPtr) {
+    return reinterpret_cast<memex::TranscriptionResult *>(resultPtr);
+}
+
+static memex::CancelToken * cancel_from_jlong(jlong cancelPtr) {
+    return reinterpret_cast<memex::CancelToken *>(cancelPtr);
+}
+
+// A NativeAudioRingBuffer holds one reference to its ring; streaming
+// sessions reading from it hold another, so closing the Kotlin object while
+// a session is attached does not free the ring under it
+static std::shared_ptr<memex::PcmRingBuffer> & ring_ref_from_jlong(jlong ringPtr) {
+    return *reinterpret_cast<std::shared_ptr<memex::PcmRingBuffer> *>(ringPtr);
+}
+
+static memex::PcmRingBuffer * ring_from_jlong(jlong ringPtr) {
+    return ring_ref_from_jlong(ringPtr).get();
+}
+
+// Transcriber handed to Kotlin as a jlong. Each holds one reference to a
+// registry model, so several WhisperService instances (and the legacy
+// WhisperWrapper path) share a single copy of the weights.
+static jlong handle_to_jlong(std::shared_ptr<memex::Model> model) {
+    return reinterpret_cast<jlong>(memex::make_transcriber(std::move(model)).release());
+}
+
+// Per-thread conversion scratch is kept between requests for clips up to
+// one 30 s window; a longer clip's buffer is released once its request is
+// done, so a single long recording does not pin its peak on the thread.
+static constexpr size_t kMaxRetainedSamples = 30 * WHISPER_SAMPLE_RATE;
+
+static void release_large_scratch(std::vector<float> & scratch) {
+    if (scratch.capacity() > kMaxRetainedSamples) {
+        std::vector<float>().swap(scratch);
+    }
+}
+
+// Acquire a registry model from an APK asset, loading it on first use
+static std::shared_ptr<memex::Model> acquire_model_asset(JNIEnv * env, jobject assetManager,
+                                                         const std::string & asset_path) {
+    AAssetManager * mgr = AAssetManager_fromJava(env, assetManager);
+    if (mgr == nullptr) {
+        LOGE("Failed to get native asset manager");
+        return nullptr;
+    }
+    
+    struct whisper_context_params cparams = whisper_context_default_params();
+    memex::LoadOptions options = memex::get_default_load_options();
+    return memex::ModelRegistry::instance().acquire(
+        "asset://" + asset_path, cparams, [mgr, &asset_path, &cparams, &options]() {
+            return memex::load_model_from_asset(mgr, asset_path, cparams, options);
+        });
+}
 
 extern "C" {
 
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void * /* reserved */) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    
+    // Method IDs are looked up once here, where the app class loader is visible
+    memex::init_transcription_listener(vm, env);
+    return JNI_VERSION_1_6;
+}
+
 // Helper function to convert jstring to std::string
 std::string jstring2string(JNIEnv *env, jstring jStr) {
     if (!jStr) return "";
@@ -34,32 +123,8 @@ std::string jstring2string(JNIEnv *env, jstring jStr) {
     return ret;
 }
 
-// Read audio file (WAV format expected)
-std::vector<float> read_wav(const std::string& fname) {
-    std::vector<float> pcmf32;
-    
-    FILE* file = fopen(fname.c_str(), "rb");
-    if (!file) {
-        LOGE("Failed to open audio file: %s", fname.c_str());
-        return pcmf32;
-    }
-    
-    // Skip WAV header (44 bytes for standard WAV)
-    fseek(file, 44, SEEK_SET);
-    
-    // Read PCM data
-    int16_t sample;
-    while (fread(&sample, sizeof(int16_t), 1, file) == 1) {
-        pcmf32.push_back(sample / 32768.0f);
-    }
-    
-    fclose(file);
-    LOGI("Read %zu samples from %s", pcmf32.size(), fname.c_str());
-    return pcmf32;
-}
-
 JNIEXPORT jlong JNICALL
-Java_com_memexos_app_whisper_WhisperService_initContext(
+Java_com_memexagent_app_whisper_WhisperService_initContext(
         JNIEnv *env,
         jobject /* this */,
         jstring modelPath) {
@@ -67,20 +132,18 @@ Java_com_memexos_app_whisper_WhisperService_initContext(
     std::string model_path = jstring2string(env, modelPath);
     LOGI("Initializing Whisper context with model: %s", model_path.c_str());
     
-    struct whisper_context_params cparams = whisper_context_default_params();
-    struct whisper_context * ctx = whisper_init_from_file_with_params(model_path.c_str(), cparams);
-    
-    if (ctx == nullptr) {
+    std::shared_ptr<memex::Model> model = memex::acquire_model_file(model_path);
+    if (!model) {
         LOGE("Failed to load model from: %s", model_path.c_str());
         return 0L;
     }
     
     LOGI("Whisper context initialized successfully");
-    return reinterpret_cast<jlong>(ctx);
+    return handle_to_jlong(std::move(model));
 }
 
 JNIEXPORT jlong JNICALL
-Java_com_memexos_app_whisper_WhisperService_initContextFromAsset(
+Java_com_memexagent_app_whisper_WhisperService_initContextFromAsset(
         JNIEnv *env,
         jobject /* this */,
         jobject assetManager,
@@ -89,142 +152,976 @@ Java_com_memexos_app_whisper_WhisperService_initContextFromAsset(
     std::string asset_path = jstring2string(env, assetPath);
     LOGI("Initializing Whisper context from asset: %s", asset_path.c_str());
     
-    // Get the native asset manager
-    AAssetManager* mgr = AAssetManager_fromJava(env, assetManager);
-    if (mgr == nullptr) {
-        LOGE("Failed to get native asset manager");
+    std::shared_ptr<memex::Model> model = acquire_model_asset(env, assetManager, asset_path);
+    if (!model) {
+        LOGE("Failed to initialize Whisper context from asset: %s", asset_path.c_str());
         return 0L;
     }
     
-    // Open the asset file
-    AAsset* asset = AAssetManager_open(mgr, asset_path.c_str(), AASSET_MODE_BUFFER);
-    if (asset == nullptr) {
-        LOGE("Failed to open asset: %s", asset_path.c_str());
-        return 0L;
+    LOGI("Whisper context initialized successfully from asset");
+    return handle_to_jlong(std::move(model));
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_freeContext(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr) {
+    
+    if (contextPtr != 0) {
+        // Drops this handle's reference; the weights stay cached in the
+        // registry until evicted.
+        delete handle_from_jlong(contextPtr);
+        LOGI("Whisper context freed");
     }
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_setModelLoadOptions(
+        JNIEnv *env,
+        jobject /* this */,
+        jboolean useMmap,
+        jboolean adviseHugePages) {
     
-    // Get asset size and data
-    off_t asset_size = AAsset_getLength(asset);
-    const void* asset_data = AAsset_getBuffer(asset);
+    memex::LoadOptions options;
+    options.use_mmap = useMmap == JNI_TRUE;
+    options.advise_hugepage = adviseHugePages == JNI_TRUE;
+    memex::set_default_load_options(options);
     
-    if (asset_data == nullptr || asset_size <= 0) {
-        LOGE("Failed to read asset data: %s", asset_path.c_str());
-        AAsset_close(asset);
-        return 0L;
+    LOGI("Model load options: mmap=%d hugepage=%d", options.use_mmap, options.advise_hugepage);
+}
+
+// Layout: decode threads, then per core: id, capacity, max kHz, cluster,
+// performance (1/0)
+JNIEXPORT jintArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_getCpuTopology(
+        JNIEnv *env,
+        jobject /* this */) {
+    
+    const memex::CpuTopology & topology = memex::cpu_topology();
+    std::vector<jint> values = {memex::default_thread_count()};
+    for (const memex::CpuCore & core : topology.cores) {
+        values.push_back(core.id);
+        values.push_back(core.capacity);
+        values.push_back((jint) core.max_freq_khz);
+        values.push_back(core.cluster);
+        values.push_back(core.performance ? 1 : 0);
     }
     
-    LOGI("Asset loaded successfully: %s (size: %ld bytes)", asset_path.c_str(), asset_size);
+    jintArray result = env->NewIntArray((jsize) values.size());
+    env->SetIntArrayRegion(result, 0, (jsize) values.size(), values.data());
+    return result;
+}
+
+// Layout: threads, ms per decode on a fresh thread, ms per decode on a pool
+// worker (-1 if the decodes failed)
+JNIEXPORT jdoubleArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeMeasureThreadStartup(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jint numThreads,
+        jint iterations,
+        jfloatArray audioData) {
     
-    // Initialize whisper context from buffer (cast away const)
-    struct whisper_context_params cparams = whisper_context_default_params();
-    struct whisper_context * ctx = whisper_init_from_buffer_with_params(
-        const_cast<void*>(asset_data), asset_size, cparams);
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return nullptr;
+    }
+    
+    jfloat* audio = env->GetFloatArrayElements(audioData, nullptr);
+    jsize audioLength = env->GetArrayLength(audioData);
     
-    // Close the asset
-    AAsset_close(asset);
+    const memex::ThreadStartupCost cost = memex::measure_thread_startup(
+        *handle_from_jlong(contextPtr)->model, memex::resolve_thread_count(numThreads), iterations,
+        audio, audioLength);
     
-    if (ctx == nullptr) {
-        LOGE("Failed to initialize Whisper context from asset: %s", asset_path.c_str());
-        return 0L;
+    env->ReleaseFloatArrayElements(audioData, audio, JNI_ABORT);
+    
+    const jdouble values[] = {(jdouble) cost.n_threads, cost.spawned_ms, cost.pooled_ms};
+    
+    jdoubleArray result = env->NewDoubleArray(3);
+    env->SetDoubleArrayRegion(result, 0, 3, values);
+    return result;
+}
+
+// Returns the loaded ggml CPU backend variant, "ggml" when ggml picked it,
+// or "" when the kernels are linked in statically
+JNIEXPORT jstring JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeLoadCpuBackend(
+        JNIEnv *env,
+        jobject /* this */,
+        jstring libDir) {
+    
+    const char * dir = env->GetStringUTFChars(libDir, nullptr);
+    const std::string variant = memex::load_cpu_backend(dir);
+    env->ReleaseStringUTFChars(libDir, dir);
+    
+    return env->NewStringUTF(variant.c_str());
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeGetCpuFeatures(
+        JNIEnv *env,
+        jobject /* this */) {
+    
+    const std::vector<std::string> names = memex::detect_cpu_features().names();
+    jobjectArray result = env->NewObjectArray((jsize) names.size(), env->FindClass("java/lang/String"), nullptr);
+    for (size_t i = 0; i < names.size(); ++i) {
+        jstring name = env->NewStringUTF(names[i].c_str());
+        env->SetObjectArrayElement(result, (jsize) i, name);
+        env->DeleteLocalRef(name);
     }
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeSetCorePinning(
+        JNIEnv *env,
+        jobject /* this */,
+        jboolean enabled) {
     
-    LOGI("Whisper context initialized successfully from asset");
-    return reinterpret_cast<jlong>(ctx);
+    memex::set_core_pinning(enabled == JNI_TRUE);
+    LOGI("Core pinning %s", enabled == JNI_TRUE ? "enabled" : "disabled");
 }
 
 JNIEXPORT void JNICALL
-Java_com_memexos_app_whisper_WhisperService_freeContext(
+Java_com_memexagent_app_whisper_WhisperService_setVadEnabled(
         JNIEnv *env,
         jobject /* this */,
-        jlong contextPtr) {
+        jlong contextPtr,
+        jboolean enabled,
+        jint minSilenceMs,
+        jint padMs) {
     
-    if (contextPtr != 0) {
-        struct whisper_context * ctx = reinterpret_cast<struct whisper_context *>(contextPtr);
-        whisper_free(ctx);
-        LOGI("Whisper context freed");
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return;
+    }
+    
+    // Requests in flight keep the settings they started with
+    std::shared_ptr<memex::VadSettings> vad = std::make_shared<memex::VadSettings>();
+    vad->enabled = enabled == JNI_TRUE;
+    vad->params.min_silence_ms = minSilenceMs;
+    vad->params.pad_ms = padMs;
+    std::atomic_store(&handle_from_jlong(contextPtr)->vad, std::shared_ptr<const memex::VadSettings>(std::move(vad)));
+    LOGI("VAD pre-filter %s (min silence %d ms, pad %d ms)",
+         enabled == JNI_TRUE ? "enabled" : "disabled", minSilenceMs, padMs);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeSetCommandGrammar(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jstring grammarText,
+        jfloat penalty) {
+    
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return JNI_FALSE;
+    }
+    
+    memex::Transcriber * handle = handle_from_jlong(contextPtr);
+    if (grammarText == nullptr) {
+        std::atomic_store(&handle->grammar, std::shared_ptr<const memex::CommandGrammar>());
+        LOGI("Command grammar cleared");
+        return JNI_TRUE;
+    }
+    
+    std::shared_ptr<memex::CommandGrammar> grammar = std::make_shared<memex::CommandGrammar>();
+    std::string error;
+    if (!grammar->grammar.parse(jstring2string(env, grammarText), &error)) {
+        // Never keep decoding against a grammar the caller meant to replace
+        std::atomic_store(&handle->grammar, std::shared_ptr<const memex::CommandGrammar>());
+        LOGE("Failed to parse command grammar, cleared: %s", error.c_str());
+        return JNI_FALSE;
     }
+    grammar->penalty = penalty;
+    LOGI("Command grammar set: %zu rules, penalty %.1f", grammar->grammar.n_rules(), penalty);
+    
+    std::atomic_store(&handle->grammar, std::shared_ptr<const memex::CommandGrammar>(std::move(grammar)));
+    return JNI_TRUE;
 }
 
 JNIEXPORT void JNICALL
-Java_com_memexos_app_whisper_WhisperService_fullTranscribe(
+Java_com_memexagent_app_whisper_WhisperService_nativeSetTranscriptionListener(
         JNIEnv *env,
         jobject /* this */,
         jlong contextPtr,
-        jint numThreads,
-        jfloatArray audioData) {
+        jobject listener) {
     
     if (contextPtr == 0) {
         LOGE("Invalid context pointer");
         return;
     }
     
-    struct whisper_context * ctx = reinterpret_cast<struct whisper_context *>(contextPtr);
+    std::shared_ptr<const memex::TranscriptionListener> next;
+    if (listener != nullptr) {
+        next = std::make_shared<memex::JavaTranscriptionListener>(env, listener);
+    }
+    
+    // Decodes already running keep the listener they started with
+    std::atomic_store(&handle_from_jlong(contextPtr)->listener, next);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeSetCascade(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jobject assetManager,
+        jstring modelPath,
+        jfloat threshold) {
+    
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return JNI_FALSE;
+    }
+    
+    memex::Transcriber * handle = handle_from_jlong(contextPtr);
+    if (modelPath == nullptr) {
+        std::atomic_store(&handle->cascade, std::shared_ptr<const memex::Cascade>());
+        LOGI("Model cascade disabled");
+        return JNI_TRUE;
+    }
+    
+    // The fallback model comes from the registry, so it stays resident and
+    // is shared with any service that loads it directly
+    std::string model_path = jstring2string(env, modelPath);
+    std::shared_ptr<memex::Cascade> cascade = std::make_shared<memex::Cascade>();
+    cascade->model = assetManager != nullptr
+        ? acquire_model_asset(env, assetManager, model_path)
+        : memex::acquire_model_file(model_path);
+    if (!cascade->model) {
+        LOGE("Failed to load cascade model: %s", model_path.c_str());
+        return JNI_FALSE;
+    }
+    if (cascade->model == handle->model) {
+        LOGE("Cascade model is the primary model: %s", model_path.c_str());
+        return JNI_FALSE;
+    }
+    cascade->threshold = threshold;
+    LOGI("Model cascade: escalating to %s below confidence %.2f", model_path.c_str(), threshold);
+    
+    std::atomic_store(&handle->cascade, std::shared_ptr<const memex::Cascade>(std::move(cascade)));
+    return JNI_TRUE;
+}
+
+// Layout: requests, escalated, mean primary ms, mean fallback ms, p50 ms,
+// p90 ms, then the confidence histogram counts
+JNIEXPORT jdoubleArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_getCascadeStats(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr) {
+    
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return nullptr;
+    }
+    
+    const memex::CascadeStats::Snapshot stats = handle_from_jlong(contextPtr)->cascade_stats.snapshot();
+    std::vector<jdouble> values = {
+        (jdouble) stats.n_requests, (jdouble) stats.n_escalated,
+        stats.mean_primary_ms, stats.mean_fallback_ms, stats.p50_ms, stats.p90_ms
+    };
+    for (int64_t count : stats.confidence_histogram) {
+        values.push_back((jdouble) count);
+    }
+    
+    jdoubleArray out = env->NewDoubleArray((jsize) values.size());
+    env->SetDoubleArrayRegion(out, 0, (jsize) values.size(), values.data());
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_resetCascadeStats(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr) {
+    
+    if (contextPtr != 0) {
+        handle_from_jlong(contextPtr)->cascade_stats.reset();
+    }
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_detectSpeechSegments(
+        JNIEnv *env,
+        jobject /* this */,
+        jfloatArray audioData) {
     
-    // Get audio data from Java array
     jfloat* audio = env->GetFloatArrayElements(audioData, nullptr);
     jsize audioLength = env->GetArrayLength(audioData);
     
-    LOGI("Processing %d audio samples with %d threads", audioLength, numThreads);
-    
-    // Configure whisper parameters
-    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    wparams.print_progress   = false;
-    wparams.print_special    = false;
-    wparams.print_realtime   = false;
-    wparams.print_timestamps = false;
-    wparams.translate        = false;
-    wparams.language         = "en";
-    wparams.n_threads        = numThreads;
-    wparams.offset_ms        = 0;
-    wparams.duration_ms      = 0;
-    wparams.single_segment   = false;
-    wparams.max_tokens       = 0;
-    wparams.audio_ctx        = 0;
-    
-    // Process audio
-    int result = whisper_full(ctx, wparams, audio, audioLength);
+    memex::VadParams params;
+    std::vector<memex::SpeechSegment> segments = memex::detect_speech(audio, (size_t) audioLength, params);
     
-    // Release audio data
     env->ReleaseFloatArrayElements(audioData, audio, JNI_ABORT);
     
-    if (result != 0) {
-        LOGE("Failed to process audio, error code: %d", result);
-    } else {
-        LOGI("Audio processing completed successfully");
+    // Flattened [start_ms, end_ms] pairs
+    std::vector<jlong> bounds;
+    bounds.reserve(segments.size() * 2);
+    for (const memex::SpeechSegment & seg : segments) {
+        bounds.push_back(seg.start * 1000 / params.sample_rate);
+        bounds.push_back(seg.end * 1000 / params.sample_rate);
     }
+    
+    jlongArray result = env->NewLongArray((jsize) bounds.size());
+    env->SetLongArrayRegion(result, 0, (jsize) bounds.size(), bounds.data());
+    return result;
 }
 
 JNIEXPORT jint JNICALL
-Java_com_memexos_app_whisper_WhisperService_getTextSegmentCount(
+Java_com_memexagent_app_whisper_WhisperService_nativeEvictModel(
         JNIEnv *env,
         jobject /* this */,
-        jlong contextPtr) {
+        jstring modelPath) {
+    
+    std::string model_path = jstring2string(env, modelPath);
+    size_t n_evicted = memex::ModelRegistry::instance().evict(model_path);
+    n_evicted += memex::ModelRegistry::instance().evict("asset://" + model_path);
+    return (jint) n_evicted;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeEvictUnusedModels(
+        JNIEnv *env,
+        jobject /* this */) {
+    
+    return (jint) memex::ModelRegistry::instance().evict_unused();
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_whisper_WhisperService_fullTranscribe(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jint numThreads,
+        jint profileId,
+        jfloatArray audioData,
+        jlong cancelPtr) {
+    
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return 0L;
+    }
+    
+    memex::TraceScope scope;
+    
+    // Get audio data from Java array
+    jfloat* audio = nullptr;
+    jsize audioLength = 0;
+    {
+        memex::TraceSpan input(memex::STAGE_JNI_INPUT);
+        audio = env->GetFloatArrayElements(audioData, nullptr);
+        audioLength = env->GetArrayLength(audioData);
+    }
+    
+    memex::TranscriptionResult * result = memex::transcribe(*handle_from_jlong(contextPtr), numThreads, profileId,
+                                                            audio, audioLength, cancel_from_jlong(cancelPtr)).release();
+    
+    // Release audio data
+    env->ReleaseFloatArrayElements(audioData, audio, JNI_ABORT);
+    
+    return reinterpret_cast<jlong>(result);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_whisper_WhisperService_fullTranscribePcm16(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jint numThreads,
+        jint profileId,
+        jobject pcmBuffer,
+        jint offsetBytes,
+        jint lengthBytes,
+        jlong cancelPtr) {
     
     if (contextPtr == 0) {
         LOGE("Invalid context pointer");
+        return 0L;
+    }
+    
+    // Direct buffers only: heap buffers would need a copy through a Java array
+    const uint8_t * pcm = static_cast<const uint8_t *>(env->GetDirectBufferAddress(pcmBuffer));
+    const jlong capacity = env->GetDirectBufferCapacity(pcmBuffer);
+    if (pcm == nullptr || capacity < 0) {
+        LOGE("PCM buffer is not a direct ByteBuffer");
+        return 0L;
+    }
+    if (offsetBytes < 0 || lengthBytes < 0 || (jlong) offsetBytes + lengthBytes > capacity) {
+        LOGE("PCM range [%d, +%d) outside buffer of %lld bytes", offsetBytes, lengthBytes, (long long) capacity);
+        return 0L;
+    }
+    
+    memex::TraceScope scope;
+    
+    // Convert straight from the recorder's int16 samples into a per-thread
+    // scratch buffer that is reused across requests
+    static thread_local std::vector<float> pcmf32;
+    const size_t n_samples = (size_t) lengthBytes / sizeof(int16_t);
+    {
+        memex::TraceSpan input(memex::STAGE_JNI_INPUT);
+        pcmf32.resize(n_samples);
+        memex::pcm_s16le_bytes_to_f32(pcm + offsetBytes, pcmf32.data(), n_samples);
+    }
+    
+    memex::TranscriptionResult * result = memex::transcribe(
+        *handle_from_jlong(contextPtr), numThreads, profileId, pcmf32.data(), (int) n_samples,
+        cancel_from_jlong(cancelPtr)).release();
+    release_large_scratch(pcmf32);
+    
+    return reinterpret_cast<jlong>(result);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_whisper_WhisperService_fullTranscribeRing(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jint numThreads,
+        jint profileId,
+        jlong ringPtr,
+        jint maxSamples,
+        jlong cancelPtr) {
+    
+    if (contextPtr == 0 || ringPtr == 0) {
+        LOGE("Invalid context or ring buffer pointer");
+        return 0L;
+    }
+    
+    memex::PcmRingBuffer * ring = ring_from_jlong(ringPtr);
+    
+    memex::TraceScope scope;
+    
+    // Convert straight out of ring memory; the samples are consumed once the
+    // decode has its own float copy
+    static thread_local std::vector<float> pcmf32;
+    {
+        memex::TraceSpan input(memex::STAGE_JNI_INPUT);
+        memex::PcmRingBuffer::View view = ring->peek(maxSamples > 0 ? (size_t) maxSamples : ring->capacity());
+        pcmf32.resize(view.size());
+        memex::view_to_f32(view, pcmf32.data());
+        ring->consume(view.size());
+    }
+    
+    memex::TranscriptionResult * result = memex::transcribe(
+        *handle_from_jlong(contextPtr), numThreads, profileId, pcmf32.data(), (int) pcmf32.size(),
+        cancel_from_jlong(cancelPtr)).release();
+    release_large_scratch(pcmf32);
+    
+    return reinterpret_cast<jlong>(result);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_whisper_WhisperService_fullTranscribeLong(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jint numThreads,
+        jfloatArray audioData,
+        jint overlapMs,
+        jint maxChunkMs,
+        jint parallelism,
+        jlong cancelPtr) {
+    
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return 0L;
+    }
+    
+    memex::LongFormParams params;
+    params.n_threads    = numThreads;
+    params.overlap_ms   = overlapMs;
+    params.max_chunk_ms = maxChunkMs;
+    params.n_workers    = parallelism;
+    
+    memex::TraceScope scope;
+    jfloat* audio = nullptr;
+    jsize audioLength = 0;
+    {
+        memex::TraceSpan input(memex::STAGE_JNI_INPUT);
+        audio = env->GetFloatArrayElements(audioData, nullptr);
+        audioLength = env->GetArrayLength(audioData);
+    }
+    
+    memex::TranscriptionResult * result = memex::transcribe_long_form(
+        *handle_from_jlong(contextPtr), params, audio, (size_t) audioLength,
+        cancel_from_jlong(cancelPtr)).release();
+    
+    env->ReleaseFloatArrayElements(audioData, audio, JNI_ABORT);
+    
+    return reinterpret_cast<jlong>(result);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeCreateCancelToken(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong timeoutMs) {
+    
+    return reinterpret_cast<jlong>(new memex::CancelToken((int64_t) timeoutMs));
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeCancel(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong cancelPtr) {
+    
+    if (cancelPtr != 0) {
+        cancel_from_jlong(cancelPtr)->cancel();
+    }
+}
+
+JNIEXPORT jdouble JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeCancelLatencyMs(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong cancelPtr) {
+    
+    return cancelPtr != 0 ? cancel_from_jlong(cancelPtr)->idle_latency_ms() : -1.0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeFreeCancelToken(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong cancelPtr) {
+    
+    // Only after every decode using the token has returned
+    delete cancel_from_jlong(cancelPtr);
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_getChunkStats(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong resultPtr) {
+    
+    // Flattened [start_ms, end_ms, decode_ms, rtf] per chunk
+    std::vector<jdouble> stats;
+    if (resultPtr != 0) {
+        for (const memex::ChunkStats & chunk : result_from_jlong(resultPtr)->chunks) {
+            stats.push_back((jdouble) chunk.start_ms);
+            stats.push_back((jdouble) chunk.end_ms);
+            stats.push_back(chunk.decode_ms);
+            stats.push_back(chunk.rtf);
+        }
+    }
+    
+    jdoubleArray result = env->NewDoubleArray((jsize) stats.size());
+    env->SetDoubleArrayRegion(result, 0, (jsize) stats.size(), stats.data());
+    return result;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_getEncodeStats(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong resultPtr) {
+    
+    // [audio_ctx, encode_ms, encode_saved_ms]
+    jdouble stats[3] = {0.0, 0.0, 0.0};
+    if (resultPtr != 0) {
+        const memex::TranscriptionResult * result = result_from_jlong(resultPtr);
+        stats[0] = (jdouble) result->audio_ctx;
+        stats[1] = result->encode_ms;
+        stats[2] = result->encode_saved_ms;
+    }
+    
+    jdoubleArray array = env->NewDoubleArray(3);
+    env->SetDoubleArrayRegion(array, 0, 3, stats);
+    return array;
+}
+
+// Trace spans with sequence number >= sinceSeq, up to the first one still
+// being written, six longs each:
+// [seq, request id, stage, thread id, start us, duration us]
+JNIEXPORT jlongArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeGetStageTimings(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong sinceSeq) {
+    
+    const std::vector<memex::TraceEvent> events =
+        memex::TraceBuffer::instance().snapshot(sinceSeq > 0 ? (uint64_t) sinceSeq : 0);
+    
+    std::vector<jlong> flat;
+    flat.reserve(events.size() * 6);
+    for (const memex::TraceEvent & e : events) {
+        flat.push_back((jlong) e.seq);
+        flat.push_back((jlong) e.request_id);
+        flat.push_back((jlong) e.stage);
+        flat.push_back((jlong) e.tid);
+        flat.push_back((jlong) e.start_us);
+        flat.push_back((jlong) e.dur_us);
+    }
+    
+    jlongArray array = env->NewLongArray((jsize) flat.size());
+    env->SetLongArrayRegion(array, 0, (jsize) flat.size(), flat.data());
+    return array;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_memexagent_app_whisper_WhisperService_nativeWriteTrace(
+        JNIEnv *env,
+        jobject /* this */,
+        jstring path) {
+    
+    const std::string trace_path = jstring2string(env, path);
+    return memex::write_chrome_trace(trace_path, memex::TraceBuffer::instance().snapshot()) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_freeResult(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong resultPtr) {
+    
+    if (resultPtr != 0) {
+        // Returns the decoder state to the pool
+        delete result_from_jlong(resultPtr);
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_whisper_WhisperService_exportResult(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong resultPtr,
+        jobject buffer) {
+    
+    if (resultPtr == 0) {
+        LOGE("Invalid result pointer");
         return 0;
     }
     
-    struct whisper_context * ctx = reinterpret_cast<struct whisper_context *>(contextPtr);
-    return whisper_full_n_segments(ctx);
+    uint8_t * dst = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer));
+    const jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (dst == nullptr || capacity < 0) {
+        LOGE("Export buffer is not a direct ByteBuffer");
+        return 0;
+    }
+    
+    // Whole transcript in one copy; a too-small buffer gets the size it needs
+    memex::TranscriptionResult * result = result_from_jlong(resultPtr);
+    memex::TraceSpan span(memex::STAGE_JNI_EXPORT, result->trace_id);
+    const std::vector<uint8_t> & bytes = memex::export_result(*result);
+    if ((jlong) bytes.size() > capacity) {
+        return -(jint) bytes.size();
+    }
+    memcpy(dst, bytes.data(), bytes.size());
+    return (jint) bytes.size();
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_memexos_app_whisper_WhisperService_getTextSegment(
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_WhisperService_setDecoderStatePoolSize(
         JNIEnv *env,
         jobject /* this */,
         jlong contextPtr,
-        jint index) {
+        jint maxStates) {
     
     if (contextPtr == 0) {
         LOGE("Invalid context pointer");
-        return env->NewStringUTF("");
+        return;
     }
     
-    struct whisper_context * ctx = reinterpret_cast<struct whisper_context *>(contextPtr);
-    const char * text = whisper_full_get_segment_text(ctx, index);
+    handle_from_jlong(contextPtr)->model->states->set_max_states(maxStates);
+    LOGI("Decoder state pool size set to %d", maxStates);
+}
+
+// Layout: weights, KV self, KV cross, compute, scratch (bytes, -1 unknown),
+// decoder states, then process RSS, PSS, peak RSS, swap (bytes, -1 unknown).
+// Without a context only the process fields are filled.
+JNIEXPORT jlongArray JNICALL
+Java_com_memexagent_app_whisper_WhisperService_getMemoryStats(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr) {
+    
+    memex::ContextMemory context;
+    if (contextPtr != 0) {
+        context = memex::context_memory(*handle_from_jlong(contextPtr)->model);
+    }
+    const memex::ProcessMemory process = memex::process_memory();
     
-    return env->NewStringUTF(text ? text : "");
+    const jlong stats[10] = {
+        context.weights, context.kv_self, context.kv_cross, context.compute, context.scratch,
+        context.n_states,
+        process.rss, process.pss, process.peak_rss, process.swap,
+    };
+    
+    jlongArray array = env->NewLongArray(10);
+    env->SetLongArrayRegion(array, 0, 10, stats);
+    return array;
+}
+
+// Streaming transcription sessions
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_whisper_WhisperService_streamOpen(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong contextPtr,
+        jint numThreads,
+        jint stepMs,
+        jint lengthMs,
+        jint keepMs,
+        jboolean useVad,
+        jlong ringPtr) {
+    
+    if (contextPtr == 0) {
+        LOGE("Invalid context pointer");
+        return 0L;
+    }
+    
+    // The window arithmetic divides by the step
+    if (stepMs <= 0 || lengthMs <= 0 || keepMs < 0) {
+        LOGE("Invalid stream timing: step %d ms, length %d ms, keep %d ms", stepMs, lengthMs, keepMs);
+        return 0L;
+    }
+    
+    memex::StreamParams params;
+    params.n_threads = numThreads;
+    params.step_ms   = stepMs;
+    params.length_ms = lengthMs;
+    params.keep_ms   = keepMs;
+    params.use_vad   = useVad == JNI_TRUE;
+    
+    memex::StreamingSession * session = new memex::StreamingSession(
+        handle_from_jlong(contextPtr)->model, params,
+        ringPtr != 0 ? ring_ref_from_jlong(ringPtr) : nullptr);
+    
+    if (!session->ok()) {
+        delete session;
+        return 0L;
+    }
+    return reinterpret_cast<jlong>(session);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_whisper_StreamingSession_nativePush(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong sessionPtr,
+        jshortArray samples,
+        jint offset,
+        jint length) {
+    
+    memex::StreamingSession * session = reinterpret_cast<memex::StreamingSession *>(sessionPtr);
+    if (!session->owns_input()) {
+        // The capture thread is the only producer of an external ring
+        LOGE("push() on a streaming session that reads a capture ring");
+        return -1;
+    }
+    memex::PcmRingBuffer & input = session->input();
+    
+    memex::PcmRingBuffer::View span = input.write_span((size_t) length);
+    env->GetShortArrayRegion(samples, offset, (jsize) span.n_first,
+                             const_cast<jshort *>(span.first));
+    env->GetShortArrayRegion(samples, offset + (jsize) span.n_first, (jsize) span.n_second,
+                             const_cast<jshort *>(span.second));
+    input.commit(span.size());
+    
+    if (span.size() < (size_t) length) {
+        input.add_overrun((size_t) length - span.size());
+    }
+    return (jint) span.size();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_whisper_StreamingSession_nativePoll(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong sessionPtr) {
+    
+    return (jint) reinterpret_cast<memex::StreamingSession *>(sessionPtr)->poll();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_whisper_StreamingSession_nativeFinish(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong sessionPtr) {
+    
+    return (jint) reinterpret_cast<memex::StreamingSession *>(sessionPtr)->finish();
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_memexagent_app_whisper_StreamingSession_nativeStableText(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong sessionPtr) {
+    
+    std::string text = reinterpret_cast<memex::StreamingSession *>(sessionPtr)->stable_text();
+    return env->NewStringUTF(text.c_str());
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_memexagent_app_whisper_StreamingSession_nativeProvisionalText(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong sessionPtr) {
+    
+    std::string text = reinterpret_cast<memex::StreamingSession *>(sessionPtr)->provisional_text();
+    return env->NewStringUTF(text.c_str());
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_whisper_StreamingSession_nativeClose(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong sessionPtr) {
+    
+    // Returns the session's decoder state to the pool
+    delete reinterpret_cast<memex::StreamingSession *>(sessionPtr);
+}
+
+// Native PCM ring buffer used by the capture thread
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeCreate(
+        JNIEnv *env,
+        jobject /* this */,
+        jint capacitySamples) {
+    
+    auto * ring = new std::shared_ptr<memex::PcmRingBuffer>(
+        std::make_shared<memex::PcmRingBuffer>(capacitySamples > 0 ? (size_t) capacitySamples : 1));
+    LOGI("Created PCM ring buffer with capacity %zu samples", (*ring)->capacity());
+    return reinterpret_cast<jlong>(ring);
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeDestroy(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr) {
+    
+    // Sessions still reading the ring keep it alive until they close
+    delete &ring_ref_from_jlong(ringPtr);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeCapacity(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr) {
+    
+    return (jint) ring_from_jlong(ringPtr)->capacity();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeWriteShorts(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr,
+        jshortArray samples,
+        jint offset,
+        jint length) {
+    
+    memex::PcmRingBuffer * ring = ring_from_jlong(ringPtr);
+    
+    // Copy the Java array region directly into ring storage
+    memex::PcmRingBuffer::View span = ring->write_span((size_t) length);
+    env->GetShortArrayRegion(samples, offset, (jsize) span.n_first,
+                             const_cast<jshort *>(span.first));
+    env->GetShortArrayRegion(samples, offset + (jsize) span.n_first, (jsize) span.n_second,
+                             const_cast<jshort *>(span.second));
+    ring->commit(span.size());
+    
+    if (span.size() < (size_t) length) {
+        ring->add_overrun((size_t) length - span.size());
+    }
+    return (jint) span.size();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeWriteDirect(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr,
+        jobject pcmBuffer,
+        jint offsetBytes,
+        jint lengthBytes) {
+    
+    memex::PcmRingBuffer * ring = ring_from_jlong(ringPtr);
+    
+    const uint8_t * pcm = static_cast<const uint8_t *>(env->GetDirectBufferAddress(pcmBuffer));
+    if (pcm == nullptr) {
+        LOGE("PCM buffer is not a direct ByteBuffer");
+        return 0;
+    }
+    
+    const size_t n_samples = (size_t) lengthBytes / sizeof(int16_t);
+    memex::PcmRingBuffer::View span = ring->write_span(n_samples);
+    memcpy(const_cast<int16_t *>(span.first), pcm + offsetBytes, span.n_first * sizeof(int16_t));
+    memcpy(const_cast<int16_t *>(span.second), pcm + offsetBytes + span.n_first * sizeof(int16_t),
+           span.n_second * sizeof(int16_t));
+    ring->commit(span.size());
+    
+    if (span.size() < n_samples) {
+        ring->add_overrun(n_samples - span.size());
+    }
+    return (jint) span.size();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeRead(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr,
+        jshortArray out,
+        jint offset,
+        jint length) {
+    
+    memex::PcmRingBuffer * ring = ring_from_jlong(ringPtr);
+    
+    memex::PcmRingBuffer::View view = ring->peek((size_t) length);
+    env->SetShortArrayRegion(out, offset, (jsize) view.n_first, view.first);
+    env->SetShortArrayRegion(out, offset + (jsize) view.n_first, (jsize) view.n_second, view.second);
+    ring->consume(view.size());
+    
+    return (jint) view.size();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeAvailable(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr) {
+    
+    return (jint) ring_from_jlong(ringPtr)->size();
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeOverrunSamples(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr) {
+    
+    return (jlong) ring_from_jlong(ringPtr)->overrun_samples();
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeTotalWritten(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr) {
+    
+    return (jlong) ring_from_jlong(ringPtr)->total_written();
+}
+
+JNIEXPORT void JNICALL
+Java_com_memexagent_app_audio_NativeAudioRingBuffer_nativeClear(
+        JNIEnv *env,
+        jobject /* this */,
+        jlong ringPtr) {
+    
+    ring_from_jlong(ringPtr)->clear();
 }
 
 // Legacy method for backward compatibility
@@ -241,64 +1138,33 @@ Java_com_example_memexos_WhisperWrapper_nativeTranscribe(
     
     LOGI("Starting transcription - Audio: %s, Model: %s", audio_path.c_str(), model_path.c_str());
     
-    // Initialize whisper context with model
-    struct whisper_context_params cparams = whisper_context_default_params();
-    struct whisper_context * ctx = whisper_init_from_file_with_params(model_path.c_str(), cparams);
-    
-    if (ctx == nullptr) {
+    // Get the cached model, loading it on first use
+    std::unique_ptr<memex::Transcriber> transcriber = memex::make_transcriber(memex::acquire_model_file(model_path));
+    if (!transcriber) {
         LOGE("Failed to load model from: %s", model_path.c_str());
         return env->NewStringUTF("Error: Failed to load model");
     }
     
     // Read audio file
-    std::vector<float> pcmf32 = read_wav(audio_path);
+    std::vector<float> pcmf32 = memex::read_wav(audio_path);
     if (pcmf32.empty()) {
-        whisper_free(ctx);
         return env->NewStringUTF("Error: Failed to read audio file");
     }
     
-    // Whisper parameters
-    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    
-    // Configure parameters for better accuracy
-    wparams.print_progress   = false;
-    wparams.print_special    = false;
-    wparams.print_realtime   = false;
-    wparams.print_timestamps = false;
-    wparams.translate        = false;
-    wparams.language         = "en";
-    wparams.n_threads        = 4;  // Adjust based on device capabilities
-    wparams.offset_ms        = 0;
-    wparams.duration_ms      = 0;
-    wparams.single_segment   = false;
-    wparams.max_tokens       = 0;
-    wparams.audio_ctx        = 0;
-    
-    // Process audio
+    // Default profile; one thread per performance core
     LOGI("Processing %zu samples...", pcmf32.size());
-    if (whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size()) != 0) {
+    std::unique_ptr<memex::TranscriptionResult> result = memex::transcribe(
+        *transcriber, 0, memex::PROFILE_DEFAULT, pcmf32.data(), (int) pcmf32.size(), nullptr);
+    if (!result) {
         LOGE("Failed to process audio");
-        whisper_free(ctx);
         return env->NewStringUTF("Error: Failed to process audio");
     }
     
     // Get results
-    const int n_segments = whisper_full_n_segments(ctx);
-    LOGI("Found %d segments", n_segments);
-    
-    std::stringstream result;
-    for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
-        result << text;
-        if (i < n_segments - 1) {
-            result << " ";
-        }
-    }
-    
-    // Clean up
-    whisper_free(ctx);
+    const std::vector<memex::TranscriptSegment> segments = memex::result_segments(*result);
+    LOGI("Found %zu segments", segments.size());
     
-    std::string transcription = result.str();
+    std::string transcription = memex::transcript_text(segments);
     LOGI("Transcription complete: %s", transcription.c_str());
     
     return env->NewStringUTF(transcription.c_str());
@@ -317,7 +1183,10 @@ JNIEXPORT void JNICALL
 Java_com_example_memexos_WhisperWrapper_nativeCleanup(
         JNIEnv *env,
         jobject /* this */) {
-    LOGI("WhisperJNI cleanup (legacy)");
+    // Legacy callers have no handle to release, so free whatever the
+    // registry holds that no WhisperService is still using.
+    size_t n_evicted = memex::ModelRegistry::instance().evict_unused();
+    LOGI("WhisperJNI cleanup (legacy), evicted %zu model(s)", n_evicted);
 }
 
 } // extern "C"
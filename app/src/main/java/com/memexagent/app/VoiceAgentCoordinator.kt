@@ -10,6 +10,9 @@ import com.memexagent.app.ai.ContextualAI
 import com.memexagent.app.context.ScreenContextManager
 import com.memexagent.app.context.VisualContextProcessor
 import com.memexagent.app.voice.VoiceIntentProcessor
+import com.memexagent.app.whisper.DecodeProfile
+import com.memexagent.app.whisper.Transcript
+import com.memexagent.app.whisper.TranscriptionListener
 import com.memexagent.app.whisper.WhisperService
 import kotlinx.coroutines.*
 
@@ -61,6 +64,19 @@ class VoiceAgentCoordinator(
             // Initialize page context
             refreshPageContext()
             
+            // Constrain command decoding to the commands we can act on
+            whisperService.setCommandGrammar(voiceIntentProcessor.commandGrammar())
+            
+            // Show what has been heard so far while the decode is still running
+            whisperService.setTranscriptionListener(object : TranscriptionListener {
+                override fun onSegment(index: Int, startMs: Long, endMs: Long, text: String) {
+                    val partial = text.trim()
+                    if (partial.isNotEmpty()) {
+                        activity.runOnUiThread { onStatusUpdate?.invoke("Heard: $partial") }
+                    }
+                }
+            })
+            
             Log.d(TAG, "Voice Agent Coordinator initialized successfully")
             true
         } catch (e: Exception) {
@@ -123,8 +139,8 @@ class VoiceAgentCoordinator(
         
         // Step 1: Transcribe audio using Whisper
         onStatusUpdate?.invoke("Transcribing audio...")
-        val transcription = transcribeAudio(audioData)
-        if (transcription.isNullOrEmpty()) {
+        val transcript = transcribeAudio(audioData)
+        if (transcript == null || transcript.text.isEmpty()) {
             return ProcessingResult(
                 success = false,
                 message = "Could not transcribe audio. Please try again.",
@@ -133,7 +149,8 @@ class VoiceAgentCoordinator(
             )
         }
         
-        Log.d(TAG, "Transcribed: $transcription")
+        val transcription = transcript.text
+        Log.d(TAG, "Transcribed: $transcription (ASR confidence ${transcript.confidence})")
         
         // Step 2: Refresh page context
         onStatusUpdate?.invoke("Analyzing page context...")
@@ -154,6 +171,7 @@ class VoiceAgentCoordinator(
         } else null
         
         val voiceCommand = voiceIntentProcessor.processCommand(transcription, webPageContext)
+            .copy(asrConfidence = transcript.confidence)
         Log.d(TAG, "Processed voice command: Intent=${voiceCommand.intent}, Confidence=${voiceCommand.confidence}")
         
         // Step 4: Resolve ambiguous commands using contextual AI
@@ -303,14 +321,14 @@ class VoiceAgentCoordinator(
     
     /**
      * Transcribe audio using Whisper service.
+     * [audioData] is raw 16-bit little-endian mono PCM at 16 kHz.
      */
-    private suspend fun transcribeAudio(audioData: ByteArray): String? {
+    private suspend fun transcribeAudio(audioData: ByteArray): Transcript? {
         return try {
-            suspendCancellableCoroutine<String?> { continuation ->
-                // Note: This will need to be implemented based on your WhisperService API
-                // For now, return a mock transcription
-                continuation.resumeWith(Result.success("test transcription"))
-            }
+            whisperService.transcribePcm16Detailed(audioData, DecodeProfile.COMMAND)
+        } catch (e: CancellationException) {
+            // Let withTimeout see it; the native decode has already stopped
+            throw e
         } catch (e: Exception) {
             Log.e(TAG, "Error transcribing audio", e)
             null
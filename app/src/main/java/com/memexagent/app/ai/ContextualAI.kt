@@ -446,6 +446,9 @@ class ContextualAI {
             confidence -= 0.2f
         }
         
+        // Nothing above helps if the words themselves were misheard
+        originalCommand.asrConfidence?.let { confidence *= it }
+        
         return minOf(confidence, 1.0f)
     }
     
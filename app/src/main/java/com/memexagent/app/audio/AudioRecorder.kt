@@ -18,6 +18,7 @@ private const val SAMPLE_RATE = 16000
 private const val CHANNEL_CONFIG = AudioFormat.CHANNEL_IN_MONO
 private const val AUDIO_FORMAT = AudioFormat.ENCODING_PCM_16BIT
 private const val BUFFER_SIZE_MULTIPLIER = 4
+private const val INITIAL_CAPTURE_SECONDS = 10
 
 class AudioRecorder {
     
@@ -38,7 +39,25 @@ class AudioRecorder {
             stopRecording()
         }
         
-        recorder = AudioRecordThread(outputFile, onError)
+        recorder = AudioRecordThread(outputFile, null, onError)
+        recorder?.start()
+    }
+
+    /**
+     * Stream captured samples into [ring] for a live consumer (e.g. streaming
+     * transcription) instead of writing a WAV file. The capture thread is the
+     * ring's only producer; samples are dropped and counted as overruns if the
+     * consumer falls behind.
+     */
+    suspend fun startCapture(ring: NativeAudioRingBuffer, onError: (Exception) -> Unit) = withContext(scope.coroutineContext) {
+        Log.d(TAG, "Starting audio capture into native ring buffer (${ring.capacity} samples)")
+        
+        if (recorder != null) {
+            Log.w(TAG, "Recording already in progress, stopping previous recording")
+            stopRecording()
+        }
+        
+        recorder = AudioRecordThread(null, ring, onError)
         recorder?.start()
     }
 
@@ -55,7 +74,8 @@ class AudioRecorder {
 }
 
 private class AudioRecordThread(
-    private val outputFile: File,
+    private val outputFile: File?,
+    private val ring: NativeAudioRingBuffer?,
     private val onError: (Exception) -> Unit
 ) : Thread("AudioRecorder") {
     
@@ -96,14 +116,25 @@ private class AudioRecordThread(
                 audioRecord.startRecording()
                 Log.d("AudioRecordThread", "Recording started")
 
-                val allData = mutableListOf<Short>()
+                // Primitive, geometrically grown capture buffer for the WAV
+                // file; only allocated when recording to a file
+                var allData = if (outputFile != null) ShortArray(SAMPLE_RATE * INITIAL_CAPTURE_SECONDS) else ShortArray(0)
                 var totalSamples = 0
 
                 while (!quit.get()) {
                     val read = audioRecord.read(buffer, 0, buffer.size)
                     if (read > 0) {
-                        for (i in 0 until read) {
-                            allData.add(buffer[i])
+                        if (outputFile != null) {
+                            if (totalSamples + read > allData.size) {
+                                allData = allData.copyOf(maxOf(allData.size * 2, totalSamples + read))
+                            }
+                            System.arraycopy(buffer, 0, allData, totalSamples, read)
+                        }
+                        ring?.let {
+                            val written = it.write(buffer, 0, read)
+                            if (written < read) {
+                                Log.w("AudioRecordThread", "Ring buffer overrun, dropped ${read - written} samples")
+                            }
                         }
                         totalSamples += read
                         
@@ -123,9 +154,13 @@ private class AudioRecordThread(
                 }
 
                 audioRecord.stop()
-                Log.d("AudioRecordThread", "Recording stopped, encoding WAV file with $totalSamples samples")
-                WaveFileEncoder.encodeWaveFile(outputFile, allData.toShortArray())
-                Log.d("AudioRecordThread", "WAV file encoded successfully: ${outputFile.absolutePath}")
+                if (outputFile != null) {
+                    Log.d("AudioRecordThread", "Recording stopped, encoding WAV file with $totalSamples samples")
+                    WaveFileEncoder.encodeWaveFile(outputFile, allData.copyOf(totalSamples))
+                    Log.d("AudioRecordThread", "WAV file encoded successfully: ${outputFile.absolutePath}")
+                } else {
+                    Log.d("AudioRecordThread", "Capture stopped after $totalSamples samples, ${ring?.overrunSamples() ?: 0} overrun")
+                }
             } finally {
                 audioRecord.release()
                 Log.d("AudioRecordThread", "AudioRecord resources released")
@@ -0,0 +1,98 @@
+package com.memexagent.app.audio
+
+import java.io.Closeable
+import java.nio.ByteBuffer
+
+/**
+ * Lock-free single-producer / single-consumer ring of 16-bit PCM samples
+ * living in native memory.
+ *
+ * The capture thread is the only writer; the transcription side (e.g.
+ * [com.memexagent.app.whisper.WhisperService.transcribeRingBuffer]) is the only
+ * reader and consumes samples in native code without copying them back into
+ * Java. Storage is preallocated; when the reader falls behind, samples that do
+ * not fit are dropped and counted in [overrunSamples] instead of blocking
+ * capture.
+ */
+class NativeAudioRingBuffer(capacitySamples: Int) : Closeable {
+    
+    companion object {
+        init {
+            System.loadLibrary("memexagent_native")
+        }
+    }
+    
+    internal var nativePtr: Long = nativeCreate(capacitySamples)
+        private set
+    
+    /** False once [close] has run. */
+    val isOpen: Boolean
+        get() = nativePtr != 0L
+    
+    /** Capacity in samples (rounded up to a power of two). */
+    val capacity: Int = nativeCapacity(nativePtr)
+    
+    /**
+     * Append samples; returns how many fit. Producer thread only.
+     */
+    fun write(samples: ShortArray, offset: Int = 0, length: Int = samples.size - offset): Int {
+        require(offset >= 0 && length >= 0 && offset + length <= samples.size) { "Invalid range" }
+        return nativeWriteShorts(checkOpen(), samples, offset, length)
+    }
+    
+    /**
+     * Append little-endian 16-bit samples from a direct buffer's position to
+     * its limit; returns how many samples fit. Producer thread only.
+     */
+    fun write(pcm: ByteBuffer): Int {
+        require(pcm.isDirect) { "PCM buffer must be a direct ByteBuffer" }
+        return nativeWriteDirect(checkOpen(), pcm, pcm.position(), pcm.remaining())
+    }
+    
+    /**
+     * Copy out and consume up to [length] samples. Consumer thread only.
+     */
+    fun read(out: ShortArray, offset: Int = 0, length: Int = out.size - offset): Int {
+        require(offset >= 0 && length >= 0 && offset + length <= out.size) { "Invalid range" }
+        return nativeRead(checkOpen(), out, offset, length)
+    }
+    
+    /** Samples currently readable. */
+    fun available(): Int = nativeAvailable(checkOpen())
+    
+    /** Samples dropped because the reader fell behind. */
+    fun overrunSamples(): Long = nativeOverrunSamples(checkOpen())
+    
+    /** Samples written since creation. */
+    fun totalWritten(): Long = nativeTotalWritten(checkOpen())
+    
+    /** Drop everything readable. Consumer thread only. */
+    fun clear() = nativeClear(checkOpen())
+    
+    /**
+     * Release this object's hold on the native ring. A [com.memexagent.app.whisper.StreamingSession]
+     * opened on it keeps the ring alive until the session is closed.
+     */
+    override fun close() {
+        if (nativePtr != 0L) {
+            nativeDestroy(nativePtr)
+            nativePtr = 0L
+        }
+    }
+    
+    private fun checkOpen(): Long {
+        check(nativePtr != 0L) { "Ring buffer is closed" }
+        return nativePtr
+    }
+    
+    private external fun nativeCreate(capacitySamples: Int): Long
+    private external fun nativeDestroy(ringPtr: Long)
+    private external fun nativeCapacity(ringPtr: Long): Int
+    private external fun nativeWriteShorts(ringPtr: Long, samples: ShortArray, offset: Int, length: Int): Int
+    private external fun nativeWriteDirect(ringPtr: Long, pcm: ByteBuffer, offsetBytes: Int, lengthBytes: Int): Int
+    private external fun nativeRead(ringPtr: Long, out: ShortArray, offset: Int, length: Int): Int
+    private external fun nativeAvailable(ringPtr: Long): Int
+    private external fun nativeOverrunSamples(ringPtr: Long): Long
+    private external fun nativeTotalWritten(ringPtr: Long): Long
+    private external fun nativeClear(ringPtr: Long)
+}
@@ -20,7 +20,9 @@ class VoiceIntentProcessor {
         val originalText: String,
         val confidence: Float = 0.0f,
         val context: VisualContextProcessor.WebPageContext? = null,
-        val parameters: Map<String, String> = emptyMap()
+        val parameters: Map<String, String> = emptyMap(),
+        // Speech recogniser confidence in the transcript, if known
+        val asrConfidence: Float? = null
     )
     
     enum class CommandIntent {
@@ -135,6 +137,26 @@ class VoiceIntentProcessor {
         )
     )
     
+    // Phrases recognised when no command pattern matches
+    private val specialCasePatterns = mapOf(
+        CommandIntent.CLICK to listOf("red button", "blue link", "green text"),
+        CommandIntent.READ to listOf("what is", "tell me about"),
+        CommandIntent.FILL_FORM to listOf("sign in", "log in"),
+        CommandIntent.EXTRACT to listOf("how much", "price")
+    )
+    
+    // Intents whose phrases may be followed by free text ("search for cats")
+    private val argumentIntents = setOf(
+        CommandIntent.NAVIGATE,
+        CommandIntent.CLICK,
+        CommandIntent.FILL_FORM,
+        CommandIntent.SEARCH,
+        CommandIntent.FIND_TEXT,
+        CommandIntent.READ,
+        CommandIntent.EXTRACT,
+        CommandIntent.TRANSLATE
+    )
+    
     // Directional and positional keywords
     private val directionalKeywords = mapOf(
         "up" to "up",
@@ -200,6 +222,54 @@ class VoiceIntentProcessor {
         return command
     }
     
+    /**
+     * GBNF grammar for the command language this processor understands, for
+     * constraining Whisper's decoder (see WhisperService.setCommandGrammar).
+     *
+     * Each intent is one rule listing its phrases. Intents that take an
+     * argument allow free words after the phrase, scrolling allows a
+     * direction, and the rest must end right after the phrase, so decoding
+     * can stop as soon as a complete command has been produced.
+     */
+    fun commandGrammar(): String {
+        val phrases = linkedMapOf<CommandIntent, List<String>>()
+        for ((intent, patterns) in commandPatterns) {
+            phrases[intent] = patterns
+        }
+        for ((intent, patterns) in specialCasePatterns) {
+            phrases[intent] = phrases[intent].orEmpty() + patterns
+        }
+        
+        val ruleNames = phrases.keys.associateWith { it.name.lowercase(Locale.US).replace('_', '-') }
+        val grammar = StringBuilder()
+        grammar.appendLine("root ::= \" \"? command \".\"?")
+        grammar.appendLine("command ::= ${ruleNames.values.joinToString(" | ")}")
+        for ((intent, patterns) in phrases) {
+            val alternatives = patterns.distinct().joinToString(" | ") { grammarPhrase(it) }
+            val tail = when (intent) {
+                CommandIntent.SCROLL -> " direction?"
+                in argumentIntents -> " argument?"
+                else -> ""
+            }
+            grammar.appendLine("${ruleNames.getValue(intent)} ::= ($alternatives)$tail")
+        }
+        grammar.appendLine("direction ::= \" \" (${directionalKeywords.keys.joinToString(" | ") { "\"$it\"" }})")
+        grammar.appendLine("argument ::= \" \" word (\" \" word)*")
+        grammar.appendLine("word ::= [a-zA-Z0-9@.'-]+")
+        return grammar.toString()
+    }
+    
+    /**
+     * A phrase as a grammar item; Whisper capitalises the start of a sentence,
+     * so the first letter may be either case.
+     */
+    private fun grammarPhrase(phrase: String): String {
+        val first = phrase.first()
+        val head = "[${first.uppercaseChar()}${first.lowercaseChar()}]"
+        val rest = phrase.drop(1)
+        return if (rest.isEmpty()) head else "$head \"$rest\""
+    }
+    
     /**
      * Normalize text for better pattern matching.
      */
@@ -240,22 +310,9 @@ class VoiceIntentProcessor {
      * Handle special cases that don't fit standard patterns.
      */
     private fun handleSpecialCases(normalizedText: String): CommandIntent {
-        return when {
-            normalizedText.contains("red button") || 
-            normalizedText.contains("blue link") ||
-            normalizedText.contains("green text") -> CommandIntent.CLICK
-            
-            normalizedText.contains("what is") ||
-            normalizedText.contains("tell me about") -> CommandIntent.READ
-            
-            normalizedText.contains("sign in") ||
-            normalizedText.contains("log in") -> CommandIntent.FILL_FORM
-            
-            normalizedText.contains("how much") ||
-            normalizedText.contains("price") -> CommandIntent.EXTRACT
-            
-            else -> CommandIntent.UNKNOWN
-        }
+        return specialCasePatterns.entries.firstOrNull { (_, patterns) ->
+            patterns.any { normalizedText.contains(it) }
+        }?.key ?: CommandIntent.UNKNOWN
     }
     
     /**
@@ -0,0 +1,97 @@
+package com.memexagent.app.whisper
+
+import android.util.Log
+import com.memexagent.app.voice.VoiceIntentProcessor
+
+/**
+ * Compares grammar-constrained command decoding against free decoding on a
+ * set of labelled clips. For each mode it reports decode latency and the
+ * mis-recognition rate: how often the transcript resolves to a different
+ * intent or entities than the clip's reference text.
+ *
+ * Run it on a device with the model loaded; it temporarily replaces the
+ * service's command grammar and restores it afterwards.
+ */
+class CommandGrammarBenchmark(
+    private val whisperService: WhisperService,
+    private val intentProcessor: VoiceIntentProcessor = VoiceIntentProcessor()
+) {
+
+    companion object {
+        private const val TAG = "CommandGrammarBenchmark"
+    }
+
+    /** 16 kHz mono audio of a spoken command and what was said. */
+    class Clip(val audio: FloatArray, val reference: String)
+
+    data class ModeResult(
+        val clips: Int,
+        val meanDecodeMs: Double,
+        val p50DecodeMs: Double,
+        val p90DecodeMs: Double,
+        val misrecognitionRate: Double
+    )
+
+    data class Report(
+        val unconstrained: ModeResult,
+        val constrained: ModeResult
+    )
+
+    suspend fun run(clips: List<Clip>, grammar: String = intentProcessor.commandGrammar()): Report {
+        require(clips.isNotEmpty()) { "No clips to benchmark" }
+
+        val previousGrammar = whisperService.commandGrammar
+        try {
+            // Untimed warm-up so the first measured clip does not pay for
+            // state allocation and cold caches
+            whisperService.transcribe(clips.first().audio, DecodeProfile.COMMAND)
+
+            whisperService.setCommandGrammar(null)
+            val unconstrained = measure(clips)
+
+            check(whisperService.setCommandGrammar(grammar)) { "Command grammar does not parse" }
+            val constrained = measure(clips)
+
+            Log.i(TAG, "Unconstrained: $unconstrained")
+            Log.i(TAG, "Constrained:   $constrained")
+            return Report(unconstrained, constrained)
+        } finally {
+            whisperService.setCommandGrammar(previousGrammar)
+        }
+    }
+
+    private suspend fun measure(clips: List<Clip>): ModeResult {
+        val decodeMs = DoubleArray(clips.size)
+        var misrecognized = 0
+
+        clips.forEachIndexed { i, clip ->
+            val start = System.nanoTime()
+            val text = whisperService.transcribe(clip.audio, DecodeProfile.COMMAND)
+            decodeMs[i] = (System.nanoTime() - start) / 1e6
+
+            if (text == null || recognize(text) != recognize(clip.reference)) {
+                misrecognized++
+                Log.d(TAG, "Mis-recognized \"${clip.reference}\" as \"$text\"")
+            }
+        }
+
+        decodeMs.sort()
+        return ModeResult(
+            clips = clips.size,
+            meanDecodeMs = decodeMs.average(),
+            p50DecodeMs = percentile(decodeMs, 0.5),
+            p90DecodeMs = percentile(decodeMs, 0.9),
+            misrecognitionRate = misrecognized.toDouble() / clips.size
+        )
+    }
+
+    private fun recognize(text: String): Pair<VoiceIntentProcessor.CommandIntent, List<String>> {
+        val command = intentProcessor.processCommand(text)
+        return command.intent to command.entities
+    }
+
+    private fun percentile(sorted: DoubleArray, q: Double): Double {
+        val index = ((sorted.size - 1) * q).toInt()
+        return sorted[index]
+    }
+}
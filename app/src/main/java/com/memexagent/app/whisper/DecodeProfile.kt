@@ -0,0 +1,23 @@
+package com.memexagent.app.whisper
+
+/**
+ * Named decode parameter sets defined in native code (decode_profile.h).
+ * Only the id crosses JNI; the parameters are built once natively and
+ * reused for every request.
+ */
+enum class DecodeProfile(val id: Int) {
+    /** General transcription with timestamps. */
+    DEFAULT(0),
+    
+    /**
+     * Short voice commands: a single segment of at most 32 tokens, no
+     * timestamps or prior context, encoder sized to the clip.
+     */
+    COMMAND(1),
+    
+    /** Continuous dictation; text is conditioned on the previous window. */
+    DICTATION(2),
+    
+    /** Independent chunks of a long recording, used by [WhisperService.transcribeLong]. */
+    LONG_FORM(3)
+}
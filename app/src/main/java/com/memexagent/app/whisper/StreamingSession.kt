@@ -0,0 +1,126 @@
+package com.memexagent.app.whisper
+
+import android.util.Log
+import com.memexagent.app.audio.NativeAudioRingBuffer
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.withContext
+import java.io.Closeable
+
+/**
+ * Incremental transcription over a sliding window of live audio.
+ *
+ * Audio arrives either through [push] or from the [NativeAudioRingBuffer]
+ * the session was opened on. Each [poll] that finds at least one step of new
+ * audio re-decodes the current window and updates [provisionalText]; once per
+ * window length that text is committed to [stableText] and the window restarts,
+ * carrying the committed text forward as the decoder prompt.
+ *
+ * Create with [WhisperService.openStream]. [push] may be called from the capture
+ * thread while another thread polls; everything else belongs to the polling side.
+ * A session opened on a ring only reads from it: the ring's capture thread is its
+ * single producer, so [push] is refused.
+ */
+class StreamingSession internal constructor(
+    private var sessionPtr: Long,
+    val stepMs: Int,
+    private val ring: NativeAudioRingBuffer? = null
+) : Closeable {
+    
+    companion object {
+        private const val TAG = "StreamingSession"
+    }
+    
+    enum class PollResult(val code: Int) {
+        ERROR(-1),
+        IDLE(0),
+        PROVISIONAL(1),
+        COMMITTED(2);
+        
+        companion object {
+            fun fromCode(code: Int): PollResult = values().firstOrNull { it.code == code } ?: ERROR
+        }
+    }
+    
+    data class Update(
+        val result: PollResult,
+        val stableText: String,
+        val provisionalText: String
+    )
+    
+    /**
+     * Append 16 kHz mono 16-bit samples. Returns how many fit; the rest were
+     * dropped because polling fell behind.
+     *
+     * @throws IllegalStateException if the session reads from a ring
+     */
+    fun push(samples: ShortArray, offset: Int = 0, length: Int = samples.size - offset): Int {
+        require(offset >= 0 && length >= 0 && offset + length <= samples.size) { "Invalid range" }
+        check(ring == null) { "Session reads from a capture ring; write to the ring instead" }
+        val pushed = nativePush(checkOpen(), samples, offset, length)
+        check(pushed >= 0) { "Session does not accept pushed audio" }
+        return pushed
+    }
+    
+    /**
+     * Decode if at least one step of new audio is available. Blocks for the
+     * duration of the decode.
+     */
+    fun poll(): PollResult = PollResult.fromCode(nativePoll(checkOpen()))
+    
+    /**
+     * Decode the remaining audio and commit everything to [stableText].
+     */
+    fun finish(): PollResult = PollResult.fromCode(nativeFinish(checkOpen()))
+    
+    val stableText: String
+        get() = nativeStableText(checkOpen())
+    
+    val provisionalText: String
+        get() = nativeProvisionalText(checkOpen())
+    
+    /**
+     * Poll until the calling coroutine is cancelled, reporting every text
+     * change, then finish and report the final text.
+     */
+    suspend fun run(onUpdate: (Update) -> Unit) = withContext(Dispatchers.Default) {
+        try {
+            while (isActive) {
+                val result = poll()
+                when (result) {
+                    PollResult.IDLE -> delay((stepMs / 4).toLong().coerceAtLeast(10L))
+                    PollResult.ERROR -> {
+                        Log.e(TAG, "Streaming decode failed")
+                        return@withContext
+                    }
+                    else -> onUpdate(Update(result, stableText, provisionalText))
+                }
+            }
+        } finally {
+            if (sessionPtr != 0L) {
+                val result = finish()
+                onUpdate(Update(result, stableText, provisionalText))
+            }
+        }
+    }
+    
+    override fun close() {
+        if (sessionPtr != 0L) {
+            nativeClose(sessionPtr)
+            sessionPtr = 0L
+        }
+    }
+    
+    private fun checkOpen(): Long {
+        check(sessionPtr != 0L) { "Streaming session is closed" }
+        return sessionPtr
+    }
+    
+    private external fun nativePush(sessionPtr: Long, samples: ShortArray, offset: Int, length: Int): Int
+    private external fun nativePoll(sessionPtr: Long): Int
+    private external fun nativeFinish(sessionPtr: Long): Int
+    private external fun nativeStableText(sessionPtr: Long): String
+    private external fun nativeProvisionalText(sessionPtr: Long): String
+    private external fun nativeClose(sessionPtr: Long)
+}
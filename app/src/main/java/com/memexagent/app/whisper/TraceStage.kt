@@ -0,0 +1,38 @@
+package com.memexagent.app.whisper
+
+/**
+ * Stages of a native request recorded in the trace buffer (trace.h). Ids
+ * are shared with native code.
+ */
+enum class TraceStage(val id: Int) {
+    /** Model load on a registry miss; not tied to a request. */
+    LOAD(0),
+    
+    /** Copying or converting the request's audio out of Java memory. */
+    JNI_INPUT(1),
+    
+    /** Silence trimming with the VAD. */
+    VAD(2),
+    
+    /** Waiting for a free decoder state. */
+    STATE_WAIT(3),
+    
+    /** Log-mel spectrogram. */
+    MEL(4),
+    
+    /** Encoder, up to the first decoder logits. */
+    ENCODE(5),
+    
+    /** Token decoding. */
+    DECODE(6),
+    
+    /** The whole native request, VAD through decode. */
+    REQUEST(7),
+    
+    /** Serialising the transcript into the export buffer. */
+    JNI_EXPORT(8);
+    
+    companion object {
+        fun fromId(id: Int): TraceStage? = values().firstOrNull { it.id == id }
+    }
+}
@@ -0,0 +1,98 @@
+package com.memexagent.app.whisper
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import kotlin.math.exp
+
+/**
+ * A transcription result exported from native code in a single call, in the
+ * binary layout described in `transcript.h`. Nothing is decoded up front:
+ * segment fields and token data are read straight from the buffer, and text
+ * is only turned into Strings when asked for.
+ *
+ * Times are in milliseconds of the submitted audio. Token data covers text
+ * tokens only (no timestamp or control tokens).
+ */
+class Transcript internal constructor(buffer: ByteBuffer) {
+    
+    companion object {
+        private const val VERSION = 1
+        private const val HEADER_BYTES = 16
+        private const val SEGMENT_HEADER_BYTES = 32
+        private const val TOKEN_BYTES = 8
+    }
+    
+    private val buffer: ByteBuffer = buffer.duplicate().order(ByteOrder.nativeOrder())
+    
+    init {
+        require(this.buffer.getInt(0) == VERSION) { "Unsupported transcript layout ${this.buffer.getInt(0)}" }
+    }
+    
+    val segmentCount: Int
+        get() = buffer.getInt(4)
+    
+    /** Mean log probability of the transcript's text tokens. */
+    val avgLogprob: Float
+        get() = buffer.getFloat(8)
+    
+    /** Highest no-speech probability of any segment. */
+    val noSpeechProb: Float
+        get() = buffer.getFloat(12)
+    
+    /**
+     * Recognition confidence in [0, 1]: the geometric mean of the token
+     * probabilities, scaled by the probability that the audio held speech.
+     * 0 for an empty transcript.
+     */
+    val confidence: Float
+        get() = if (segmentCount == 0) 0f else exp(avgLogprob) * (1f - noSpeechProb)
+    
+    /** All segment texts joined with single spaces. */
+    val text: String by lazy {
+        (0 until segmentCount).joinToString(" ") { segment(it).text }.trim()
+    }
+    
+    val segments: List<Segment>
+        get() = List(segmentCount) { segment(it) }
+    
+    fun segment(index: Int): Segment {
+        require(index in 0 until segmentCount) { "Segment $index out of range" }
+        return Segment(buffer, buffer.getInt(HEADER_BYTES + 4 * index))
+    }
+    
+    /** View of one segment record. */
+    class Segment internal constructor(private val buffer: ByteBuffer, private val offset: Int) {
+        
+        val startMs: Long
+            get() = buffer.getLong(offset)
+        
+        val endMs: Long
+            get() = buffer.getLong(offset + 8)
+        
+        val avgLogprob: Float
+            get() = buffer.getFloat(offset + 16)
+        
+        val noSpeechProb: Float
+            get() = buffer.getFloat(offset + 20)
+        
+        val tokenCount: Int
+            get() = buffer.getInt(offset + 24)
+        
+        fun tokenId(index: Int): Int = buffer.getInt(tokenOffset(index))
+        
+        fun tokenProb(index: Int): Float = buffer.getFloat(tokenOffset(index) + 4)
+        
+        val text: String by lazy {
+            val bytes = ByteArray(buffer.getInt(offset + 28))
+            val view = buffer.duplicate()
+            view.position(offset + SEGMENT_HEADER_BYTES + tokenCount * TOKEN_BYTES)
+            view.get(bytes)
+            String(bytes, Charsets.UTF_8)
+        }
+        
+        private fun tokenOffset(index: Int): Int {
+            require(index in 0 until tokenCount) { "Token $index out of range" }
+            return offset + SEGMENT_HEADER_BYTES + index * TOKEN_BYTES
+        }
+    }
+}
@@ -0,0 +1,26 @@
+package com.memexagent.app.whisper
+
+/**
+ * Receives transcription results while the native decode is still running.
+ *
+ * Register with [WhisperService.setTranscriptionListener]. Methods are called
+ * on the decode thread (a native worker thread for long-form transcription),
+ * so hand off to the main thread before touching UI and return quickly: the
+ * decoder waits for each call.
+ */
+interface TranscriptionListener {
+    
+    /**
+     * A segment has been decoded. [index] counts segments within one request;
+     * [startMs] and [endMs] are relative to the start of the submitted audio.
+     * Long-form segments arrive chunk by chunk, and chunks can finish out of
+     * order. With a model cascade ([WhisperService.enableCascadeFromAsset]),
+     * only the transcript that is kept is reported, so the primary model's
+     * segments arrive after its decode and a discarded transcript is never
+     * reported.
+     */
+    fun onSegment(index: Int, startMs: Long, endMs: Long, text: String)
+    
+    /** Decode progress of the current request, 0-100. */
+    fun onProgress(percent: Int) {}
+}
@@ -2,15 +2,28 @@ package com.memexagent.app.whisper
 
 import android.content.Context
 import android.util.Log
+import com.memexagent.app.audio.NativeAudioRingBuffer
+import kotlinx.coroutines.CancellationException
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.coroutineScope
 import kotlinx.coroutines.withContext
 import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.concurrent.atomic.AtomicLong
 
 class WhisperService(private val context: Context) {
     
     companion object {
         private const val TAG = "WhisperService"
         
+        // First guess for an exported transcript; larger ones are retried once
+        private const val EXPORT_BUFFER_BYTES = 4096
+        
+        /** Thread count that lets native code use one thread per performance core. */
+        const val AUTO_THREADS = 0
+        
         init {
             try {
                 System.loadLibrary("memexagent_native")
@@ -21,9 +34,180 @@ class WhisperService(private val context: Context) {
         }
     }
     
+    /**
+     * Timing of one long-form chunk. [realTimeFactor] is decode time divided
+     * by chunk duration; below 1 is faster than real time.
+     */
+    data class ChunkStats(
+        val startMs: Long,
+        val endMs: Long,
+        val decodeMs: Double,
+        val realTimeFactor: Double
+    )
+    
+    /**
+     * Text of a short voice command plus the encoder context it ran with
+     * ([audioCtx] frames of 20 ms, 0 = full 30 s window), its encoder time and
+     * the estimated saving against a full window.
+     */
+    data class CommandTranscription(
+        val text: String,
+        val audioCtx: Int,
+        val encodeMs: Double,
+        val encodeSavedMs: Double
+    )
+    
+    data class LongTranscription(
+        val text: String,
+        val chunks: List<ChunkStats>
+    )
+    
+    /**
+     * How a model cascade has behaved since the last reset. Latencies are in
+     * milliseconds; [p50Ms] and [p90Ms] are end to end over recent requests.
+     * [confidenceHistogram] counts requests by primary-model confidence in
+     * buckets of 0.1, so other thresholds can be evaluated offline.
+     */
+    data class CascadeStats(
+        val requests: Long,
+        val escalated: Long,
+        val meanPrimaryMs: Double,
+        val meanFallbackMs: Double,
+        val p50Ms: Double,
+        val p90Ms: Double,
+        val confidenceHistogram: List<Long>
+    ) {
+        val escalationRate: Double
+            get() = if (requests > 0) escalated.toDouble() / requests else 0.0
+        
+        /** Escalation rate had the threshold been [threshold], to bucket precision. */
+        fun escalationRateAt(threshold: Float): Double {
+            if (requests == 0L) return 0.0
+            val buckets = (threshold * confidenceHistogram.size).toInt().coerceIn(0, confidenceHistogram.size)
+            return confidenceHistogram.take(buckets).sum().toDouble() / requests
+        }
+    }
+    
+    private class CascadeConfig(val modelPath: String, val fromAsset: Boolean, val threshold: Float)
+    
+    private class SilenceTrimming(val enabled: Boolean, val minSilenceMs: Int, val padMs: Int)
+    
+    /**
+     * One CPU core as seen by the native layer. [capacity] is the kernel's
+     * relative performance (1024 for the fastest core, 0 if not exposed) and
+     * [cluster] counts from the slowest cluster up.
+     */
+    data class CpuCore(
+        val id: Int,
+        val capacity: Int,
+        val maxFreqKhz: Int,
+        val cluster: Int,
+        val performance: Boolean
+    )
+    
+    /**
+     * Milliseconds per decode with [threads] threads, run from a fresh thread
+     * each time ([spawnedMs], which starts a new OpenMP team per call as a
+     * short-lived dispatcher thread would) and on a parked compute worker
+     * whose team is reused ([pooledMs]).
+     */
+    data class ThreadStartupCost(
+        val threads: Int,
+        val spawnedMs: Double,
+        val pooledMs: Double
+    )
+    
+    /**
+     * CPU layout decodes are scheduled on: [threads] decode threads by
+     * default, pinned to the [performanceCores].
+     */
+    data class CpuLayout(
+        val threads: Int,
+        val cores: List<CpuCore>
+    ) {
+        val performanceCores: List<CpuCore>
+            get() = cores.filter { it.performance }
+        
+        val clusters: Int
+            get() = cores.map { it.cluster }.distinct().size
+    }
+    
+    /**
+     * One timed stage of a native request. Spans of the same request share
+     * [requestId] (0 for model loads); times are microseconds on the
+     * monotonic clock.
+     */
+    data class StageTiming(
+        val requestId: Long,
+        val stage: TraceStage,
+        val threadId: Int,
+        val startUs: Long,
+        val durationUs: Long
+    )
+    
+    /**
+     * Native memory of the loaded model in bytes: its weights and, summed over
+     * the [decoderStates] allocated so far, the self-attention and
+     * cross-attention KV caches, compute graph buffers and scratch. Null
+     * where whisper.cpp did not report a size. The process fields come from
+     * /proc/self; [pssBytes] splits shared pages between processes.
+     */
+    data class MemoryStats(
+        val weightsBytes: Long?,
+        val kvSelfBytes: Long?,
+        val kvCrossBytes: Long?,
+        val computeBytes: Long?,
+        val scratchBytes: Long?,
+        val decoderStates: Int,
+        val rssBytes: Long?,
+        val pssBytes: Long?,
+        val peakRssBytes: Long?,
+        val swapBytes: Long?
+    ) {
+        /** Sum of the model's known native buffers. */
+        val contextBytes: Long
+            get() = listOfNotNull(weightsBytes, kvSelfBytes, kvCrossBytes, computeBytes, scratchBytes).sum()
+    }
+    
     private var contextPtr: Long = 0L
     private var isInitialized = false
     
+    /** GBNF grammar applied to [DecodeProfile.COMMAND] requests, if any. */
+    var commandGrammar: String? = null
+        private set
+    private var grammarPenalty = 100f
+    
+    private var cascadeConfig: CascadeConfig? = null
+    
+    private var silenceTrimming: SilenceTrimming? = null
+    
+    /**
+     * ggml CPU backend variant picked for this device's instruction set
+     * (e.g. "android_armv8.2_2"), "ggml" if ggml chose it, or "" when the
+     * kernels are linked in statically. Null until a model is first loaded.
+     */
+    var cpuBackend: String? = null
+        private set
+    
+    /** Instruction-set extensions the native layer detected, e.g. "dotprod". */
+    val cpuFeatures: List<String>
+        get() = nativeGetCpuFeatures().toList()
+    
+    // Sequence number of the next trace span pollStageTimings() returns
+    private var traceCursor = 0L
+    
+    /** Receives partial results; see [setTranscriptionListener]. */
+    var transcriptionListener: TranscriptionListener? = null
+        private set
+    
+    /**
+     * How long the native decode took to stop after the most recent
+     * cancellation or missed deadline, in milliseconds; -1 if none yet.
+     */
+    @Volatile
+    var lastCancelLatencyMs: Double = -1.0
+        private set
+    
     /**
      * Initialize Whisper with a model file from assets
      */
@@ -33,11 +217,20 @@ class WhisperService(private val context: Context) {
                 release()
             }
             
+            loadCpuBackend()
             contextPtr = initContextFromAsset(context.assets, assetPath)
             isInitialized = contextPtr != 0L
             
             if (isInitialized) {
                 Log.d(TAG, "Whisper initialized successfully from asset: $assetPath")
+                if (commandGrammar != null) {
+                    applyCommandGrammar()
+                }
+                transcriptionListener?.let { nativeSetTranscriptionListener(contextPtr, it) }
+                if (cascadeConfig != null) {
+                    applyCascade()
+                }
+                applySilenceTrimming()
             } else {
                 Log.e(TAG, "Failed to initialize Whisper from asset: $assetPath")
             }
@@ -58,11 +251,20 @@ class WhisperService(private val context: Context) {
                 release()
             }
             
+            loadCpuBackend()
             contextPtr = initContext(modelPath)
             isInitialized = contextPtr != 0L
             
             if (isInitialized) {
                 Log.d(TAG, "Whisper initialized successfully from file: $modelPath")
+                if (commandGrammar != null) {
+                    applyCommandGrammar()
+                }
+                transcriptionListener?.let { nativeSetTranscriptionListener(contextPtr, it) }
+                if (cascadeConfig != null) {
+                    applyCascade()
+                }
+                applySilenceTrimming()
             } else {
                 Log.e(TAG, "Failed to initialize Whisper from file: $modelPath")
             }
@@ -75,34 +277,353 @@ class WhisperService(private val context: Context) {
     }
     
     /**
-     * Transcribe audio data
+     * Load the CPU kernels matching this device before the first model; the
+     * native side does this once per process.
+     */
+    private fun loadCpuBackend() {
+        if (cpuBackend == null) {
+            cpuBackend = nativeLoadCpuBackend(context.applicationInfo.nativeLibraryDir)
+            Log.d(TAG, "CPU backend: ${cpuBackend?.ifEmpty { "built-in" }}")
+        }
+    }
+    
+    /**
+     * Transcribe audio data with the given decode [profile]. Cancelling the
+     * calling coroutine stops the native decode; a positive [timeoutMs] also
+     * stops it (returning null) once that much time has passed.
+     */
+    suspend fun transcribe(
+        audioData: FloatArray,
+        profile: DecodeProfile = DecodeProfile.DEFAULT,
+        timeoutMs: Long = 0
+    ): String? = transcribeDetailed(audioData, profile, timeoutMs)?.text
+    
+    /**
+     * Like [transcribe], but returns the full [Transcript] with segment
+     * timestamps, token probabilities and an utterance confidence.
+     */
+    suspend fun transcribeDetailed(
+        audioData: FloatArray,
+        profile: DecodeProfile = DecodeProfile.DEFAULT,
+        timeoutMs: Long = 0
+    ): Transcript? = withContext(Dispatchers.IO) {
+        if (!isInitialized) {
+            Log.e(TAG, "Whisper not initialized")
+            return@withContext null
+        }
+        
+        try {
+            // One thread per performance core, pinned to them. Each call decodes
+            // on its own native decoder state, so concurrent calls do not race.
+            val resultPtr = decodeCancellable(timeoutMs) { cancelPtr ->
+                fullTranscribe(contextPtr, AUTO_THREADS, profile.id, audioData, cancelPtr)
+            }
+            if (resultPtr == 0L) {
+                Log.e(TAG, "Native transcription failed")
+                return@withContext null
+            }
+            
+            return@withContext exportTranscript(resultPtr)
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.e(TAG, "Error during transcription", e)
+            return@withContext null
+        }
+    }
+    
+    /**
+     * Transcribe a short voice command (16 kHz mono). The encoder only covers
+     * the clip plus a safety margin instead of a padded 30 s window; clips
+     * longer than 15 s fall back to the full window. Uses [DecodeProfile.COMMAND].
+     * Cancellation and [timeoutMs] behave as in [transcribe].
+     */
+    suspend fun transcribeCommand(audioData: FloatArray, timeoutMs: Long = 0): CommandTranscription? = withContext(Dispatchers.IO) {
+        if (!isInitialized) {
+            Log.e(TAG, "Whisper not initialized")
+            return@withContext null
+        }
+        
+        try {
+            val resultPtr = decodeCancellable(timeoutMs) { cancelPtr ->
+                fullTranscribe(contextPtr, AUTO_THREADS, DecodeProfile.COMMAND.id, audioData, cancelPtr)
+            }
+            if (resultPtr == 0L) {
+                Log.e(TAG, "Native transcription failed")
+                return@withContext null
+            }
+            
+            val stats = getEncodeStats(resultPtr)
+            val text = exportTranscript(resultPtr)?.text ?: return@withContext null
+            return@withContext CommandTranscription(text, stats[0].toInt(), stats[1], stats[2])
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.e(TAG, "Error during transcription", e)
+            return@withContext null
+        }
+    }
+    
+    /**
+     * Transcribe a long recording (16 kHz mono) by splitting it at pauses and
+     * decoding the chunks in parallel, each on its own decoder state.
+     *
+     * @param overlapMs audio decoded past each chunk edge; segments from the
+     *   overlap are dropped in favour of the neighbouring chunk
+     * @param maxChunkMs longest chunk; keep at or below the 30 s encoder window
+     * @param parallelism chunks decoded at once, 0 = as many decoder states as
+     *   are free (see [setMaxConcurrentTranscriptions])
+     * @param numThreads decode threads shared by all chunks
+     * @param timeoutMs stop decoding (returning null) after this long, 0 = no
+     *   deadline; cancelling the calling coroutine stops it as well
      */
-    suspend fun transcribe(audioData: FloatArray): String? = withContext(Dispatchers.IO) {
+    suspend fun transcribeLong(
+        audioData: FloatArray,
+        overlapMs: Int = 500,
+        maxChunkMs: Int = 25000,
+        parallelism: Int = 0,
+        numThreads: Int = AUTO_THREADS,
+        timeoutMs: Long = 0
+    ): LongTranscription? = withContext(Dispatchers.IO) {
         if (!isInitialized) {
             Log.e(TAG, "Whisper not initialized")
             return@withContext null
         }
         
         try {
-            // Run transcription with 4 threads by default
-            fullTranscribe(contextPtr, 4, audioData)
+            val resultPtr = decodeCancellable(timeoutMs) { cancelPtr ->
+                fullTranscribeLong(contextPtr, numThreads, audioData, overlapMs, maxChunkMs, parallelism, cancelPtr)
+            }
+            if (resultPtr == 0L) {
+                Log.e(TAG, "Native long-form transcription failed")
+                return@withContext null
+            }
             
-            // Get the transcribed text
-            val textCount = getTextSegmentCount(contextPtr)
-            val result = StringBuilder()
+            val stats = getChunkStats(resultPtr)
+            val chunks = (stats.indices step 4).map { i ->
+                ChunkStats(stats[i].toLong(), stats[i + 1].toLong(), stats[i + 2], stats[i + 3])
+            }
+            val text = exportTranscript(resultPtr)?.text ?: return@withContext null
+            return@withContext LongTranscription(text, chunks)
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.e(TAG, "Error during long-form transcription", e)
+            return@withContext null
+        }
+    }
+    
+    /**
+     * Transcribe 16-bit little-endian mono PCM at 16 kHz (what AudioRecord
+     * produces), read from [pcm]'s position to its limit.
+     *
+     * [pcm] must be a direct buffer: native code converts the samples to float
+     * in place, so no FloatArray is ever allocated on the Java heap.
+     * Cancellation and [timeoutMs] behave as in [transcribe].
+     */
+    suspend fun transcribePcm16(
+        pcm: ByteBuffer,
+        profile: DecodeProfile = DecodeProfile.DEFAULT,
+        timeoutMs: Long = 0
+    ): String? = transcribePcm16Detailed(pcm, profile, timeoutMs)?.text
+    
+    /**
+     * Like [transcribePcm16], but returns the full [Transcript].
+     */
+    suspend fun transcribePcm16Detailed(
+        pcm: ByteBuffer,
+        profile: DecodeProfile = DecodeProfile.DEFAULT,
+        timeoutMs: Long = 0
+    ): Transcript? = withContext(Dispatchers.IO) {
+        if (!isInitialized) {
+            Log.e(TAG, "Whisper not initialized")
+            return@withContext null
+        }
+        
+        if (!pcm.isDirect) {
+            Log.e(TAG, "PCM buffer must be a direct ByteBuffer")
+            return@withContext null
+        }
+        
+        try {
+            val resultPtr = decodeCancellable(timeoutMs) { cancelPtr ->
+                fullTranscribePcm16(contextPtr, AUTO_THREADS, profile.id, pcm, pcm.position(), pcm.remaining(), cancelPtr)
+            }
+            if (resultPtr == 0L) {
+                Log.e(TAG, "Native transcription failed")
+                return@withContext null
+            }
             
-            for (i in 0 until textCount) {
-                val segment = getTextSegment(contextPtr, i)
-                result.append(segment).append(" ")
+            return@withContext exportTranscript(resultPtr)
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.e(TAG, "Error during transcription", e)
+            return@withContext null
+        }
+    }
+    
+    /**
+     * Transcribe 16-bit little-endian mono PCM at 16 kHz held in a byte array.
+     */
+    suspend fun transcribePcm16(
+        pcm: ByteArray,
+        profile: DecodeProfile = DecodeProfile.DEFAULT,
+        timeoutMs: Long = 0
+    ): String? = transcribePcm16Detailed(pcm, profile, timeoutMs)?.text
+    
+    /**
+     * Like [transcribePcm16], but returns the full [Transcript].
+     */
+    suspend fun transcribePcm16Detailed(
+        pcm: ByteArray,
+        profile: DecodeProfile = DecodeProfile.DEFAULT,
+        timeoutMs: Long = 0
+    ): Transcript? {
+        val buffer = ByteBuffer.allocateDirect(pcm.size).order(ByteOrder.LITTLE_ENDIAN)
+        buffer.put(pcm).flip()
+        return transcribePcm16Detailed(buffer, profile, timeoutMs)
+    }
+    
+    /**
+     * Transcribe and consume up to [maxSamples] samples currently readable in
+     * [ring] (all of them when [maxSamples] is 0). The samples are converted in
+     * native code straight out of ring memory. Call from the ring's consumer
+     * thread only. Cancellation and [timeoutMs] behave as in [transcribe].
+     */
+    suspend fun transcribeRingBuffer(
+        ring: NativeAudioRingBuffer,
+        maxSamples: Int = 0,
+        profile: DecodeProfile = DecodeProfile.DEFAULT,
+        timeoutMs: Long = 0
+    ): String? = withContext(Dispatchers.IO) {
+        if (!isInitialized) {
+            Log.e(TAG, "Whisper not initialized")
+            return@withContext null
+        }
+        
+        try {
+            val resultPtr = decodeCancellable(timeoutMs) { cancelPtr ->
+                fullTranscribeRing(contextPtr, AUTO_THREADS, profile.id, ring.nativePtr, maxSamples, cancelPtr)
+            }
+            if (resultPtr == 0L) {
+                Log.e(TAG, "Native transcription failed")
+                return@withContext null
             }
             
-            return@withContext result.toString().trim()
+            return@withContext exportTranscript(resultPtr)?.text
+        } catch (e: CancellationException) {
+            throw e
         } catch (e: Exception) {
             Log.e(TAG, "Error during transcription", e)
             return@withContext null
         }
     }
     
+    /**
+     * Open a streaming transcription session over a sliding window.
+     *
+     * @param stepMs how much new audio triggers a decode
+     * @param lengthMs sliding window length; text is committed once per window
+     * @param keepMs audio carried across a commit so boundary words survive
+     * @param useVad skip decoding silent steps and commit at pauses
+     * @param ring if given, the session consumes audio from this ring instead of
+     *   [StreamingSession.push]. The session keeps the native ring alive until it
+     *   is closed, even if [ring] is closed first.
+     * @throws IllegalArgumentException if [stepMs] or [lengthMs] is not positive
+     *   or [keepMs] is negative
+     * @throws IllegalStateException if [ring] is already closed
+     */
+    fun openStream(
+        stepMs: Int = 500,
+        lengthMs: Int = 5000,
+        keepMs: Int = 200,
+        useVad: Boolean = true,
+        ring: NativeAudioRingBuffer? = null
+    ): StreamingSession? {
+        require(stepMs > 0 && lengthMs > 0 && keepMs >= 0) { "Invalid stream timing: step $stepMs, length $lengthMs, keep $keepMs" }
+        check(ring == null || ring.isOpen) { "Ring buffer is closed" }
+        if (!isInitialized) {
+            Log.e(TAG, "Whisper not initialized")
+            return null
+        }
+        
+        val sessionPtr = streamOpen(contextPtr, AUTO_THREADS, stepMs, lengthMs, keepMs, useVad, ring?.nativePtr ?: 0L)
+        if (sessionPtr == 0L) {
+            Log.e(TAG, "Failed to open streaming session")
+            return null
+        }
+        return StreamingSession(sessionPtr, stepMs, ring)
+    }
+    
+    /**
+     * Run a blocking native decode so that it can be stopped from outside.
+     * The decode runs in a child coroutine; if the caller is cancelled while
+     * waiting for it, the native cancel token aborts whisper_full at its next
+     * check, and this only returns once the decode has actually stopped, so
+     * the token is never freed under it. A positive [timeoutMs] is enforced
+     * natively as a deadline. Returns the decode's result pointer.
+     *
+     * If the cancel loses the race and the decode still returns a result, it
+     * is freed here: a result holds a decoder state, and a leaked one would
+     * shrink the pool for good.
+     */
+    private suspend fun decodeCancellable(timeoutMs: Long, decode: (cancelPtr: Long) -> Long): Long {
+        val cancelPtr = nativeCreateCancelToken(timeoutMs)
+        // Kept outside the Deferred, which drops its value once cancelled
+        val produced = AtomicLong(0L)
+        try {
+            return coroutineScope {
+                val result = async { decode(cancelPtr).also { produced.set(it) } }
+                try {
+                    result.await()
+                } catch (e: CancellationException) {
+                    nativeCancel(cancelPtr)
+                    throw e
+                }
+            }.also { produced.set(0L) }
+        } catch (e: CancellationException) {
+            // coroutineScope rethrows only after the decode has returned
+            val orphan = produced.getAndSet(0L)
+            if (orphan != 0L) {
+                freeResult(orphan)
+            }
+            throw e
+        } finally {
+            val idleMs = nativeCancelLatencyMs(cancelPtr)
+            if (idleMs >= 0) {
+                lastCancelLatencyMs = idleMs
+                Log.i(TAG, "Native decode stopped %.1f ms after cancellation".format(idleMs))
+            }
+            nativeFreeCancelToken(cancelPtr)
+        }
+    }
+    
+    /**
+     * Copy a native result out in a single call and free it. The transcript
+     * is decoded lazily from the returned buffer.
+     */
+    private fun exportTranscript(resultPtr: Long): Transcript? {
+        try {
+            var buffer = ByteBuffer.allocateDirect(EXPORT_BUFFER_BYTES)
+            var size = exportResult(resultPtr, buffer)
+            if (size < 0) {
+                // Too small; the native side reports the size it needs
+                buffer = ByteBuffer.allocateDirect(-size)
+                size = exportResult(resultPtr, buffer)
+            }
+            if (size <= 0) {
+                Log.e(TAG, "Failed to export transcription result")
+                return null
+            }
+            
+            buffer.limit(size)
+            return Transcript(buffer)
+        } finally {
+            freeResult(resultPtr)
+        }
+    }
+    
     /**
      * Transcribe audio from WAV file
      */
@@ -122,7 +643,11 @@ class WhisperService(private val context: Context) {
     }
     
     /**
-     * Release Whisper resources
+     * Release Whisper resources.
+     *
+     * The model itself stays cached in the native model registry so the next
+     * initialize call with the same model is instant; use [evictModel] or
+     * [evictUnusedModels] to actually free the weights.
      */
     fun release() {
         if (isInitialized && contextPtr != 0L) {
@@ -133,11 +658,312 @@ class WhisperService(private val context: Context) {
         }
     }
     
+    /**
+     * Choose how model files are read by subsequent file-based loads.
+     * Memory-mapped loading (the default) streams the weights straight out of
+     * the page cache with read-ahead hints; pass false to compare against the
+     * stdio loader. Load time and RSS growth are logged for both paths.
+     */
+    fun setModelLoading(useMmap: Boolean, adviseHugePages: Boolean = false) {
+        setModelLoadOptions(useMmap, adviseHugePages)
+    }
+    
+    /**
+     * Trim silence with the native voice activity detector before decoding.
+     * Speech segments are stitched together with short gaps, pauses longer
+     * than [minSilenceMs] split segments, and [padMs] of context is kept around
+     * each one. Clips with no speech skip decoding entirely.
+     *
+     * May be called before initialization; the setting is applied to every
+     * model loaded afterwards.
+     */
+    fun setSilenceTrimming(enabled: Boolean, minSilenceMs: Int = 300, padMs: Int = 150) {
+        silenceTrimming = SilenceTrimming(enabled, minSilenceMs, padMs)
+        if (isInitialized) {
+            applySilenceTrimming()
+        }
+    }
+    
+    private fun applySilenceTrimming() {
+        val settings = silenceTrimming ?: return
+        setVadEnabled(contextPtr, settings.enabled, settings.minSilenceMs, settings.padMs)
+    }
+    
+    /**
+     * Constrain [DecodeProfile.COMMAND] decoding to a GBNF grammar whose start
+     * rule is `root` (e.g. [com.memexagent.app.voice.VoiceIntentProcessor.commandGrammar]).
+     * Tokens the grammar does not allow have [penalty] subtracted from their
+     * logits, and end-of-text is only allowed once a full command is decoded.
+     * Pass null to decode freely. The grammar is kept across re-initialization.
+     *
+     * @return false if the grammar does not parse; the previous one is dropped
+     */
+    fun setCommandGrammar(grammar: String?, penalty: Float = 100f): Boolean {
+        commandGrammar = grammar
+        grammarPenalty = penalty
+        return !isInitialized || applyCommandGrammar()
+    }
+    
+    private fun applyCommandGrammar(): Boolean {
+        if (nativeSetCommandGrammar(contextPtr, commandGrammar, grammarPenalty)) {
+            return true
+        }
+        // The native side has already dropped the previous grammar
+        Log.e(TAG, "Invalid command grammar, decoding unconstrained")
+        commandGrammar = null
+        return false
+    }
+    
+    /**
+     * Push segments and progress of every following transcription on this
+     * service to [listener] while it decodes, so partial text can be shown
+     * before the call returns. Pass null to stop. Transcriptions already
+     * running keep the listener they started with. The listener is kept
+     * across re-initialization.
+     */
+    fun setTranscriptionListener(listener: TranscriptionListener?) {
+        transcriptionListener = listener
+        if (isInitialized) {
+            nativeSetTranscriptionListener(contextPtr, listener)
+        }
+    }
+    
+    /**
+     * Decode with the loaded model first and re-decode with the larger model
+     * at asset [assetPath] only when the first transcript's confidence is
+     * below [threshold] (see [Transcript.confidence]). The fallback model is
+     * loaded now and stays resident. With a [TranscriptionListener], segments
+     * of an escalated request are pushed again from the fallback decode. The
+     * cascade is kept across re-initialization.
+     *
+     * @return false if the fallback model cannot be loaded; no cascade is set
+     */
+    fun enableCascadeFromAsset(assetPath: String, threshold: Float = 0.6f): Boolean {
+        cascadeConfig = CascadeConfig(assetPath, fromAsset = true, threshold = threshold)
+        return !isInitialized || applyCascade()
+    }
+    
+    /** As [enableCascadeFromAsset], with the fallback model at file [modelPath]. */
+    fun enableCascadeFromFile(modelPath: String, threshold: Float = 0.6f): Boolean {
+        cascadeConfig = CascadeConfig(modelPath, fromAsset = false, threshold = threshold)
+        return !isInitialized || applyCascade()
+    }
+    
+    /** Decode with the loaded model only. */
+    fun disableCascade() {
+        cascadeConfig = null
+        if (isInitialized) {
+            nativeSetCascade(contextPtr, null, null, 0f)
+        }
+    }
+    
+    private fun applyCascade(): Boolean {
+        val config = cascadeConfig ?: return true
+        val assets = if (config.fromAsset) context.assets else null
+        if (nativeSetCascade(contextPtr, assets, config.modelPath, config.threshold)) {
+            return true
+        }
+        Log.e(TAG, "Failed to load cascade model ${config.modelPath}, decoding without fallback")
+        cascadeConfig = null
+        nativeSetCascade(contextPtr, null, null, 0f)
+        return false
+    }
+    
+    /**
+     * Escalation rate, latencies and confidence distribution of the cascade,
+     * or null if not initialized.
+     */
+    fun getCascadeStats(): CascadeStats? {
+        if (!isInitialized) {
+            return null
+        }
+        val values = getCascadeStats(contextPtr)
+        return CascadeStats(
+            requests = values[0].toLong(),
+            escalated = values[1].toLong(),
+            meanPrimaryMs = values[2],
+            meanFallbackMs = values[3],
+            p50Ms = values[4],
+            p90Ms = values[5],
+            confidenceHistogram = values.drop(6).map { it.toLong() }
+        )
+    }
+    
+    fun resetCascadeStats() {
+        if (isInitialized) {
+            resetCascadeStats(contextPtr)
+        }
+    }
+    
+    /**
+     * The device's CPU layout read from sysfs, and how many decode threads
+     * [AUTO_THREADS] resolves to.
+     */
+    fun getCpuLayout(): CpuLayout {
+        val values = getCpuTopology()
+        val cores = (1 until values.size step 5).map { i ->
+            CpuCore(values[i], values[i + 1], values[i + 2], values[i + 3], values[i + 4] != 0)
+        }
+        return CpuLayout(values[0], cores)
+    }
+    
+    /**
+     * Measure what the persistent compute pool saves by decoding [audio]
+     * [iterations] times from fresh threads and as many times on a pool
+     * worker. Takes 2 * [iterations] + 1 decodes; run it off the main thread.
+     *
+     * @return the timings, or null if no model is loaded or the decodes failed
+     */
+    fun measureThreadStartup(audio: FloatArray, threads: Int = AUTO_THREADS, iterations: Int = 5): ThreadStartupCost? {
+        if (!isInitialized) {
+            return null
+        }
+        val values = nativeMeasureThreadStartup(contextPtr, threads, iterations, audio) ?: return null
+        if (values[1] < 0) {
+            return null
+        }
+        return ThreadStartupCost(
+            threads = values[0].toInt(),
+            spawnedMs = values[1],
+            pooledMs = values[2]
+        )
+    }
+    
+    /**
+     * Pin decode threads to the performance cores (on by default). Turning it
+     * off lets the scheduler place them anywhere, little cores included.
+     */
+    fun setCorePinning(enabled: Boolean) {
+        nativeSetCorePinning(enabled)
+    }
+    
+    /**
+     * Stage timings recorded since the previous call, oldest first. A span
+     * still being written, and any after it, come with the next call. The
+     * native buffer is process-wide and keeps the most recent 4096 spans, so
+     * poll at least that often to see every one.
+     */
+    fun pollStageTimings(): List<StageTiming> {
+        val values = nativeGetStageTimings(traceCursor)
+        val timings = ArrayList<StageTiming>(values.size / 6)
+        for (i in values.indices step 6) {
+            traceCursor = values[i] + 1
+            val stage = TraceStage.fromId(values[i + 2].toInt()) ?: continue
+            timings.add(StageTiming(values[i + 1], stage, values[i + 3].toInt(), values[i + 4], values[i + 5]))
+        }
+        return timings
+    }
+    
+    /**
+     * Write the spans still in the native trace buffer to [file] as Chrome
+     * trace JSON, for chrome://tracing or ui.perfetto.dev.
+     */
+    fun writeTrace(file: File): Boolean {
+        val written = nativeWriteTrace(file.absolutePath)
+        if (!written) {
+            Log.e(TAG, "Failed to write trace to ${file.absolutePath}")
+        }
+        return written
+    }
+    
+    /**
+     * Speech segments in [audioData] (16 kHz mono) as millisecond ranges.
+     */
+    fun detectSpeech(audioData: FloatArray): List<LongRange> {
+        val bounds = detectSpeechSegments(audioData)
+        return (bounds.indices step 2).map { i -> bounds[i] until bounds[i + 1] }
+    }
+    
+    /**
+     * Set how many transcriptions may decode concurrently against the loaded
+     * model. Each slot costs one decoder state (KV cache + compute buffers);
+     * the weights are shared.
+     */
+    fun setMaxConcurrentTranscriptions(maxStates: Int) {
+        if (!isInitialized) {
+            Log.e(TAG, "Whisper not initialized")
+            return
+        }
+        setDecoderStatePoolSize(contextPtr, maxStates)
+    }
+    
+    /**
+     * Memory used by the loaded model and the process. Decoder states are
+     * allocated on first use, so call this after a transcription to include
+     * them.
+     */
+    fun getMemoryStats(): MemoryStats? {
+        if (!isInitialized) {
+            return null
+        }
+        val values = getMemoryStats(contextPtr).map { it.takeIf { bytes -> bytes >= 0 } }
+        return MemoryStats(
+            weightsBytes = values[0],
+            kvSelfBytes = values[1],
+            kvCrossBytes = values[2],
+            computeBytes = values[3],
+            scratchBytes = values[4],
+            decoderStates = values[5]?.toInt() ?: 0,
+            rssBytes = values[6],
+            pssBytes = values[7],
+            peakRssBytes = values[8],
+            swapBytes = values[9]
+        )
+    }
+    
+    /**
+     * Evict a cached model (file path or asset path) from the native registry.
+     * Instances still using it keep working; memory is freed once they release.
+     */
+    fun evictModel(modelPath: String): Int {
+        val evicted = nativeEvictModel(modelPath)
+        Log.d(TAG, "Evicted $evicted cached model(s) for $modelPath")
+        return evicted
+    }
+    
+    /**
+     * Free every cached model that no WhisperService currently holds.
+     */
+    fun evictUnusedModels(): Int {
+        val evicted = nativeEvictUnusedModels()
+        Log.d(TAG, "Evicted $evicted unused cached model(s)")
+        return evicted
+    }
+    
     // Native methods - these will be linked to the C++ implementation
     private external fun initContext(modelPath: String): Long
     private external fun initContextFromAsset(assetManager: android.content.res.AssetManager, assetPath: String): Long
     private external fun freeContext(contextPtr: Long)
-    private external fun fullTranscribe(contextPtr: Long, numThreads: Int, audioData: FloatArray)
-    private external fun getTextSegmentCount(contextPtr: Long): Int
-    private external fun getTextSegment(contextPtr: Long, index: Int): String
+    private external fun fullTranscribe(contextPtr: Long, numThreads: Int, profileId: Int, audioData: FloatArray, cancelPtr: Long): Long
+    private external fun fullTranscribePcm16(contextPtr: Long, numThreads: Int, profileId: Int, pcm: ByteBuffer, offsetBytes: Int, lengthBytes: Int, cancelPtr: Long): Long
+    private external fun fullTranscribeRing(contextPtr: Long, numThreads: Int, profileId: Int, ringPtr: Long, maxSamples: Int, cancelPtr: Long): Long
+    private external fun getEncodeStats(resultPtr: Long): DoubleArray
+    private external fun fullTranscribeLong(contextPtr: Long, numThreads: Int, audioData: FloatArray, overlapMs: Int, maxChunkMs: Int, parallelism: Int, cancelPtr: Long): Long
+    private external fun nativeCreateCancelToken(timeoutMs: Long): Long
+    private external fun nativeCancel(cancelPtr: Long)
+    private external fun nativeCancelLatencyMs(cancelPtr: Long): Double
+    private external fun nativeFreeCancelToken(cancelPtr: Long)
+    private external fun getChunkStats(resultPtr: Long): DoubleArray
+    private external fun nativeGetStageTimings(sinceSeq: Long): LongArray
+    private external fun nativeWriteTrace(path: String): Boolean
+    private external fun freeResult(resultPtr: Long)
+    private external fun streamOpen(contextPtr: Long, numThreads: Int, stepMs: Int, lengthMs: Int, keepMs: Int, useVad: Boolean, ringPtr: Long): Long
+    private external fun exportResult(resultPtr: Long, buffer: ByteBuffer): Int
+    private external fun setDecoderStatePoolSize(contextPtr: Long, maxStates: Int)
+    private external fun getMemoryStats(contextPtr: Long): LongArray
+    private external fun setVadEnabled(contextPtr: Long, enabled: Boolean, minSilenceMs: Int, padMs: Int)
+    private external fun nativeSetCommandGrammar(contextPtr: Long, grammar: String?, penalty: Float): Boolean
+    private external fun nativeSetTranscriptionListener(contextPtr: Long, listener: TranscriptionListener?)
+    private external fun nativeSetCascade(contextPtr: Long, assetManager: android.content.res.AssetManager?, modelPath: String?, threshold: Float): Boolean
+    private external fun getCascadeStats(contextPtr: Long): DoubleArray
+    private external fun resetCascadeStats(contextPtr: Long)
+    private external fun detectSpeechSegments(audioData: FloatArray): LongArray
+    private external fun setModelLoadOptions(useMmap: Boolean, adviseHugePages: Boolean)
+    private external fun getCpuTopology(): IntArray
+    private external fun nativeSetCorePinning(enabled: Boolean)
+    private external fun nativeLoadCpuBackend(libDir: String): String
+    private external fun nativeGetCpuFeatures(): Array<String>
+    private external fun nativeMeasureThreadStartup(contextPtr: Long, numThreads: Int, iterations: Int, audioData: FloatArray): DoubleArray?
+    private external fun nativeEvictModel(modelPath: String): Int
+    private external fun nativeEvictUnusedModels(): Int
 }
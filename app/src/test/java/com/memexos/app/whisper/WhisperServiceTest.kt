@@ -1,14 +1,20 @@
 package com.memexos.app.whisper
 
 import android.content.Context
+import android.content.pm.ApplicationInfo
 import android.content.res.AssetManager
 import com.google.common.truth.Truth.assertThat
 import com.memexos.app.AssetTestHelper
 import com.memexos.app.TestCoroutineRule
 import io.mockk.*
+import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.ExperimentalCoroutinesApi
+import kotlinx.coroutines.cancelAndJoin
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.test.runTest
+import kotlinx.coroutines.withContext
 import org.junit.After
+import org.junit.Assert.assertThrows
 import org.junit.Before
 import org.junit.Rule
 import org.junit.Test
@@ -16,6 +22,11 @@ import org.junit.runner.RunWith
 import org.robolectric.RobolectricTestRunner
 import java.io.File
 import java.io.FileNotFoundException
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+import kotlin.math.ln
 
 /**
  * Unit tests for WhisperService.
@@ -40,6 +51,9 @@ class WhisperServiceTest {
     
     // Mock the JNI native methods
     private val mockContextPtr = 12345L
+    private val mockResultPtr = 67890L
+    private val mockCancelPtr = 24680L
+    private val nativeLibDir = "/data/app/com.memexos.app/lib/arm64"
     
     @Before
     fun setUp() {
@@ -51,6 +65,7 @@ class WhisperServiceTest {
             )
         )
         every { context.assets } returns assetManager
+        every { context.applicationInfo } returns ApplicationInfo().apply { nativeLibraryDir = nativeLibDir }
 
         // Create WhisperService instance
         whisperService = spyk(WhisperService(context))
@@ -61,13 +76,20 @@ class WhisperServiceTest {
 
     private fun mockNativeMethods() {
         // Mock native method calls using spyk and every
+        every { whisperService["nativeLoadCpuBackend"](any<String>()) } returns "android_armv8.2_2"
         every { whisperService["initContext"](any<String>()) } returns mockContextPtr
         every { whisperService["initContextFromAsset"](any<AssetManager>(), any<String>()) } returns mockContextPtr
         every { whisperService["freeContext"](any<Long>()) } just Runs
-        every { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<FloatArray>()) } just Runs
-        every { whisperService["getTextSegmentCount"](any<Long>()) } returns 2
-        every { whisperService["getTextSegment"](mockContextPtr, 0) } returns "Hello"
-        every { whisperService["getTextSegment"](mockContextPtr, 1) } returns "world"
+        every { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<Int>(), any<FloatArray>(), any<Long>()) } returns mockResultPtr
+        every { whisperService["fullTranscribePcm16"](any<Long>(), any<Int>(), any<Int>(), any<ByteBuffer>(), any<Int>(), any<Int>(), any<Long>()) } returns mockResultPtr
+        every { whisperService["freeResult"](any<Long>()) } just Runs
+        every { whisperService["nativeCreateCancelToken"](any<Long>()) } returns mockCancelPtr
+        every { whisperService["nativeCancel"](any<Long>()) } just Runs
+        every { whisperService["nativeCancelLatencyMs"](any<Long>()) } returns -1.0
+        every { whisperService["nativeFreeCancelToken"](any<Long>()) } just Runs
+        every { whisperService["exportResult"](any<Long>(), any<ByteBuffer>()) } answers {
+            exportTranscript(args[1] as ByteBuffer, "Hello", "world")
+        }
     }
 
     @After
@@ -145,10 +167,313 @@ class WhisperServiceTest {
 
         // Then
         assertThat(result).isEqualTo("Hello world")
-        verify { whisperService["fullTranscribe"](mockContextPtr, 4, audioData) }
-        verify { whisperService["getTextSegmentCount"](mockContextPtr) }
-        verify { whisperService["getTextSegment"](mockContextPtr, 0) }
-        verify { whisperService["getTextSegment"](mockContextPtr, 1) }
+        verify { whisperService["fullTranscribe"](mockContextPtr, WhisperService.AUTO_THREADS, DecodeProfile.DEFAULT.id, audioData, mockCancelPtr) }
+        verify(exactly = 1) { whisperService["exportResult"](mockResultPtr, any<ByteBuffer>()) }
+        verify(exactly = 1) { whisperService["freeResult"](mockResultPtr) }
+    }
+
+    @Test
+    fun `transcribe - native decode fails - returns null without reading segments`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData()
+        every { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<Int>(), any<FloatArray>(), any<Long>()) } returns 0L
+
+        // When
+        val result = whisperService.transcribe(audioData)
+
+        // Then
+        assertThat(result).isNull()
+        verify(exactly = 0) { whisperService["exportResult"](any<Long>(), any<ByteBuffer>()) }
+        verify(exactly = 0) { whisperService["freeResult"](any<Long>()) }
+    }
+
+    @Test
+    fun `transcribe - with profile - passes profile id to native`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData()
+
+        // When
+        val result = whisperService.transcribe(audioData, DecodeProfile.DICTATION)
+
+        // Then
+        assertThat(result).isEqualTo("Hello world")
+        verify { whisperService["fullTranscribe"](mockContextPtr, WhisperService.AUTO_THREADS, DecodeProfile.DICTATION.id, audioData, mockCancelPtr) }
+    }
+
+    @Test
+    fun `transcribeCommand - returns text with encoder stats`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData(1.5f, 440.0f)
+        every { whisperService["getEncodeStats"](mockResultPtr) } returns doubleArrayOf(384.0, 120.0, 350.0)
+
+        // When
+        val result = whisperService.transcribeCommand(audioData)
+
+        // Then
+        assertThat(result).isEqualTo(WhisperService.CommandTranscription("Hello world", 384, 120.0, 350.0))
+        verify { whisperService["fullTranscribe"](mockContextPtr, WhisperService.AUTO_THREADS, DecodeProfile.COMMAND.id, audioData, mockCancelPtr) }
+        verify(exactly = 1) { whisperService["freeResult"](mockResultPtr) }
+    }
+
+    @Test
+    fun `setCommandGrammar - before initialization - applied once context exists`() = testCoroutineRule.runTest {
+        // Given
+        val grammar = "root ::= \" \"? [Ss] \"croll down\""
+        every { whisperService["nativeSetCommandGrammar"](any<Long>(), any<String>(), any<Float>()) } returns true
+
+        // When
+        val accepted = whisperService.setCommandGrammar(grammar)
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+
+        // Then
+        assertThat(accepted).isTrue()
+        assertThat(whisperService.commandGrammar).isEqualTo(grammar)
+        verify(exactly = 1) { whisperService["nativeSetCommandGrammar"](mockContextPtr, grammar, 100f) }
+    }
+
+    @Test
+    fun `setTranscriptionListener - before initialization - registered once context exists`() = testCoroutineRule.runTest {
+        // Given
+        val listener = mockk<TranscriptionListener>(relaxed = true)
+        every { whisperService["nativeSetTranscriptionListener"](any<Long>(), any<TranscriptionListener>()) } just Runs
+
+        // When
+        whisperService.setTranscriptionListener(listener)
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+
+        // Then
+        assertThat(whisperService.transcriptionListener).isSameInstanceAs(listener)
+        verify(exactly = 1) { whisperService["nativeSetTranscriptionListener"](mockContextPtr, listener) }
+    }
+
+    @Test
+    fun `setTranscriptionListener - null - unregisters native listener`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        every { whisperService["nativeSetTranscriptionListener"](any<Long>(), isNull<TranscriptionListener>()) } just Runs
+
+        // When
+        whisperService.setTranscriptionListener(null)
+
+        // Then
+        assertThat(whisperService.transcriptionListener).isNull()
+        verify(exactly = 1) { whisperService["nativeSetTranscriptionListener"](mockContextPtr, isNull<TranscriptionListener>()) }
+    }
+
+    @Test
+    fun `setCommandGrammar - grammar does not parse - returns false and clears it`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        every { whisperService["nativeSetCommandGrammar"](any<Long>(), any<String>(), any<Float>()) } returns true
+        whisperService.setCommandGrammar("root ::= \"lights on\"")
+        every { whisperService["nativeSetCommandGrammar"](any<Long>(), any<String>(), any<Float>()) } returns false
+
+        // When
+        val accepted = whisperService.setCommandGrammar("root ::= undefined-rule")
+
+        // Then: the failed native call has already cleared the old grammar
+        assertThat(accepted).isFalse()
+        assertThat(whisperService.commandGrammar).isNull()
+        verify(exactly = 0) { whisperService["nativeSetCommandGrammar"](any<Long>(), isNull<String>(), any<Float>()) }
+    }
+
+    @Test
+    fun `enableCascadeFromAsset - before initialization - fallback loaded once context exists`() = testCoroutineRule.runTest {
+        // Given
+        every { whisperService["nativeSetCascade"](any<Long>(), any<AssetManager>(), any<String>(), any<Float>()) } returns true
+
+        // When
+        val accepted = whisperService.enableCascadeFromAsset("models/ggml-base.bin", threshold = 0.5f)
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+
+        // Then
+        assertThat(accepted).isTrue()
+        verify(exactly = 1) { whisperService["nativeSetCascade"](mockContextPtr, assetManager, "models/ggml-base.bin", 0.5f) }
+    }
+
+    @Test
+    fun `getCascadeStats - reports escalation rate at current and other thresholds`() = testCoroutineRule.runTest {
+        // Given: 10 requests, 3 below 0.6 confidence and escalated
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val histogram = doubleArrayOf(0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 2.0, 3.0, 2.0, 0.0)
+        every { whisperService["getCascadeStats"](mockContextPtr) } returns
+            doubleArrayOf(10.0, 3.0, 120.0, 480.0, 130.0, 610.0) + histogram
+
+        // When
+        val stats = whisperService.getCascadeStats()
+
+        // Then
+        assertThat(stats).isNotNull()
+        assertThat(stats!!.requests).isEqualTo(10)
+        assertThat(stats.escalationRate).isWithin(1e-9).of(0.3)
+        assertThat(stats.escalationRateAt(0.8f)).isWithin(1e-9).of(0.8)
+        assertThat(stats.p90Ms).isEqualTo(610.0)
+    }
+
+    @Test
+    fun `getMemoryStats - two decoder states, PSS unavailable - sums known buffers`() = testCoroutineRule.runTest {
+        // Given: weights plus two states' caches and buffers; no smaps_rollup
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        every { whisperService["getMemoryStats"](mockContextPtr) } returns longArrayOf(
+            77_690_000, 6_290_000, 18_870_000, 203_120_000, 3_150_000, 2,
+            412_000_000, -1, 455_000_000, 0
+        )
+
+        // When
+        val stats = whisperService.getMemoryStats()
+
+        // Then
+        assertThat(stats).isNotNull()
+        assertThat(stats!!.decoderStates).isEqualTo(2)
+        assertThat(stats.pssBytes).isNull()
+        assertThat(stats.contextBytes).isEqualTo(309_120_000L)
+    }
+
+    @Test
+    fun `transcribeLong - returns stitched text and per-chunk stats`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData(1.0f, 440.0f)
+        every { whisperService["fullTranscribeLong"](any<Long>(), any<Int>(), any<FloatArray>(), any<Int>(), any<Int>(), any<Int>(), any<Long>()) } returns mockResultPtr
+        every { whisperService["getChunkStats"](mockResultPtr) } returns doubleArrayOf(
+            0.0, 24000.0, 6000.0, 0.25,
+            24000.0, 41000.0, 3400.0, 0.2
+        )
+
+        // When
+        val result = whisperService.transcribeLong(audioData, overlapMs = 300, parallelism = 2, numThreads = 8)
+
+        // Then
+        assertThat(result).isNotNull()
+        assertThat(result!!.text).isEqualTo("Hello world")
+        assertThat(result.chunks).containsExactly(
+            WhisperService.ChunkStats(0L, 24000L, 6000.0, 0.25),
+            WhisperService.ChunkStats(24000L, 41000L, 3400.0, 0.2)
+        ).inOrder()
+        verify { whisperService["fullTranscribeLong"](mockContextPtr, 8, audioData, 300, 25000, 2, mockCancelPtr) }
+        verify(exactly = 1) { whisperService["freeResult"](mockResultPtr) }
+    }
+
+    @Test
+    fun `measureThreadStartup - decodes on fresh threads and on the pool - reports both`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audio = FloatArray(16000)
+        every { whisperService["nativeMeasureThreadStartup"](mockContextPtr, any<Int>(), any<Int>(), audio) } returns
+            doubleArrayOf(4.0, 412.0, 388.0)
+
+        // When
+        val cost = whisperService.measureThreadStartup(audio, iterations = 3)
+
+        // Then
+        assertThat(cost).isEqualTo(WhisperService.ThreadStartupCost(4, 412.0, 388.0))
+        verify { whisperService["nativeMeasureThreadStartup"](mockContextPtr, WhisperService.AUTO_THREADS, 3, audio) }
+    }
+
+    @Test
+    fun `measureThreadStartup - decodes fail - returns null`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        every { whisperService["nativeMeasureThreadStartup"](mockContextPtr, any<Int>(), any<Int>(), any<FloatArray>()) } returns
+            doubleArrayOf(4.0, -1.0, -1.0)
+
+        // When
+        val cost = whisperService.measureThreadStartup(FloatArray(16000))
+
+        // Then
+        assertThat(cost).isNull()
+    }
+
+    @Test
+    fun `initializeFromAsset - loads CPU backend once before the first model`() = testCoroutineRule.runTest {
+        // When
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        whisperService.initializeFromFile("/data/models/ggml-base.bin")
+
+        // Then
+        assertThat(whisperService.cpuBackend).isEqualTo("android_armv8.2_2")
+        verifyOrder {
+            whisperService["nativeLoadCpuBackend"](nativeLibDir)
+            whisperService["initContextFromAsset"](assetManager, "models/ggml-tiny.bin")
+        }
+        verify(exactly = 1) { whisperService["nativeLoadCpuBackend"](any<String>()) }
+    }
+
+    @Test
+    fun `pollStageTimings - consecutive polls - resume after the last span returned`() {
+        // Given: a load, then mel and encode spans of request 7 on a worker thread
+        every { whisperService["nativeGetStageTimings"](0L) } returns longArrayOf(
+            0, 0, TraceStage.LOAD.id.toLong(), 101, 1_000, 250_000,
+            1, 7, TraceStage.MEL.id.toLong(), 102, 260_000, 4_000,
+            2, 7, TraceStage.ENCODE.id.toLong(), 102, 264_000, 90_000
+        )
+        every { whisperService["nativeGetStageTimings"](3L) } returns longArrayOf()
+
+        // When
+        val first = whisperService.pollStageTimings()
+        val second = whisperService.pollStageTimings()
+
+        // Then
+        assertThat(first.map { it.stage }).containsExactly(TraceStage.LOAD, TraceStage.MEL, TraceStage.ENCODE).inOrder()
+        assertThat(first[2]).isEqualTo(WhisperService.StageTiming(7, TraceStage.ENCODE, 102, 264_000, 90_000))
+        assertThat(second).isEmpty()
+        verifyOrder {
+            whisperService["nativeGetStageTimings"](0L)
+            whisperService["nativeGetStageTimings"](3L)
+        }
+    }
+
+    @Test
+    fun `getCpuLayout - big little device - reports performance cores and thread count`() {
+        // Given: four little cores, three big and one prime
+        val cores = (0..7).flatMap { id ->
+            when {
+                id < 4 -> listOf(id, 325, 1800000, 0, 0)
+                id < 7 -> listOf(id, 870, 2400000, 1, 1)
+                else -> listOf(id, 1024, 3000000, 2, 1)
+            }
+        }
+        every { whisperService["getCpuTopology"]() } returns (listOf(4) + cores).toIntArray()
+
+        // When
+        val layout = whisperService.getCpuLayout()
+
+        // Then
+        assertThat(layout.threads).isEqualTo(4)
+        assertThat(layout.clusters).isEqualTo(3)
+        assertThat(layout.performanceCores.map { it.id }).containsExactly(4, 5, 6, 7).inOrder()
+        assertThat(layout.cores[7]).isEqualTo(WhisperService.CpuCore(7, 1024, 3000000, 2, true))
+    }
+
+    @Test
+    fun `transcribePcm16 - byte array - passes whole buffer to native and returns text`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val pcm = ByteArray(3200)
+
+        // When
+        val result = whisperService.transcribePcm16(pcm)
+
+        // Then
+        assertThat(result).isEqualTo("Hello world")
+        verify { whisperService["fullTranscribePcm16"](mockContextPtr, WhisperService.AUTO_THREADS, DecodeProfile.DEFAULT.id, any<ByteBuffer>(), 0, 3200, mockCancelPtr) }
+        verify(exactly = 1) { whisperService["freeResult"](mockResultPtr) }
+    }
+
+    @Test
+    fun `transcribePcm16 - heap buffer - returns null without calling native`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+
+        // When
+        val result = whisperService.transcribePcm16(ByteBuffer.allocate(3200))
+
+        // Then
+        assertThat(result).isNull()
+        verify(exactly = 0) { whisperService["fullTranscribePcm16"](any<Long>(), any<Int>(), any<Int>(), any<ByteBuffer>(), any<Int>(), any<Int>(), any<Long>()) }
     }
 
     @Test
@@ -161,7 +486,7 @@ class WhisperServiceTest {
 
         // Then
         assertThat(result).isNull()
-        verify(exactly = 0) { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<FloatArray>()) }
+        verify(exactly = 0) { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<Int>(), any<FloatArray>(), any<Long>()) }
     }
 
     @Test
@@ -169,7 +494,7 @@ class WhisperServiceTest {
         // Given
         whisperService.initializeFromAsset("models/ggml-tiny.bin")
         val audioData = AssetTestHelper.createTestAudioData()
-        every { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<FloatArray>()) } throws RuntimeException("Transcription error")
+        every { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<Int>(), any<FloatArray>(), any<Long>()) } throws RuntimeException("Transcription error")
 
         // When
         val result = whisperService.transcribe(audioData)
@@ -178,12 +503,129 @@ class WhisperServiceTest {
         assertThat(result).isNull()
     }
 
+    @Test
+    fun `transcribe - with timeout - passes deadline to native and frees token`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData()
+
+        // When
+        val result = whisperService.transcribe(audioData, timeoutMs = 2000)
+
+        // Then
+        assertThat(result).isEqualTo("Hello world")
+        verify(exactly = 1) { whisperService["nativeCreateCancelToken"](2000L) }
+        verify(exactly = 0) { whisperService["nativeCancel"](any<Long>()) }
+        verify(exactly = 1) { whisperService["nativeFreeCancelToken"](mockCancelPtr) }
+    }
+
+    @Test
+    fun `transcribe - coroutine cancelled mid-decode - aborts native decode`() = testCoroutineRule.runTest {
+        // Given a native decode that blocks until it is cancelled
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData()
+        val decodeStarted = CountDownLatch(1)
+        val cancelRequested = CountDownLatch(1)
+        every { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<Int>(), any<FloatArray>(), any<Long>()) } answers {
+            decodeStarted.countDown()
+            cancelRequested.await(5, TimeUnit.SECONDS)
+            0L
+        }
+        every { whisperService["nativeCancel"](mockCancelPtr) } answers { cancelRequested.countDown() }
+        every { whisperService["nativeCancelLatencyMs"](mockCancelPtr) } returns 3.5
+
+        // When
+        val job = launch(Dispatchers.IO) { whisperService.transcribe(audioData) }
+        withContext(Dispatchers.IO) { decodeStarted.await(5, TimeUnit.SECONDS) }
+        job.cancelAndJoin()
+
+        // Then the token is cancelled before it is freed
+        verifyOrder {
+            whisperService["nativeCancel"](mockCancelPtr)
+            whisperService["nativeFreeCancelToken"](mockCancelPtr)
+        }
+        assertThat(whisperService.lastCancelLatencyMs).isEqualTo(3.5)
+        verify(exactly = 0) { whisperService["freeResult"](any<Long>()) }
+    }
+
+    @Test
+    fun `transcribe - cancel loses the race - frees the result the decode returned`() = testCoroutineRule.runTest {
+        // Given a native decode that finishes with a result although it was cancelled
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData()
+        val decodeStarted = CountDownLatch(1)
+        val cancelRequested = CountDownLatch(1)
+        every { whisperService["fullTranscribe"](any<Long>(), any<Int>(), any<Int>(), any<FloatArray>(), any<Long>()) } answers {
+            decodeStarted.countDown()
+            cancelRequested.await(5, TimeUnit.SECONDS)
+            mockResultPtr
+        }
+        every { whisperService["nativeCancel"](mockCancelPtr) } answers { cancelRequested.countDown() }
+
+        // When
+        val job = launch(Dispatchers.IO) { whisperService.transcribe(audioData) }
+        withContext(Dispatchers.IO) { decodeStarted.await(5, TimeUnit.SECONDS) }
+        job.cancelAndJoin()
+
+        // Then the result, and with it its decoder state, is released unread
+        verify(exactly = 1) { whisperService["freeResult"](mockResultPtr) }
+        verify(exactly = 0) { whisperService["exportResult"](any<Long>(), any<ByteBuffer>()) }
+        verifyOrder {
+            whisperService["nativeCancel"](mockCancelPtr)
+            whisperService["freeResult"](mockResultPtr)
+            whisperService["nativeFreeCancelToken"](mockCancelPtr)
+        }
+    }
+
+    @Test
+    fun `transcribeDetailed - returns timestamps and token confidences`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData()
+
+        // When
+        val transcript = whisperService.transcribeDetailed(audioData)
+
+        // Then
+        assertThat(transcript).isNotNull()
+        assertThat(transcript!!.text).isEqualTo("Hello world")
+        assertThat(transcript.segmentCount).isEqualTo(2)
+        val second = transcript.segment(1)
+        assertThat(second.startMs).isEqualTo(1000L)
+        assertThat(second.endMs).isEqualTo(2000L)
+        assertThat(second.tokenCount).isEqualTo(1)
+        assertThat(second.tokenProb(0)).isEqualTo(0.5f)
+        assertThat(transcript.confidence).isWithin(1e-4f).of(0.5f * 0.9f)
+        verify(exactly = 1) { whisperService["freeResult"](mockResultPtr) }
+    }
+
+    @Test
+    fun `transcribe - export buffer too small - retries with reported size`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        val audioData = AssetTestHelper.createTestAudioData()
+        val longText = "word ".repeat(1500).trim()
+        every { whisperService["exportResult"](any<Long>(), any<ByteBuffer>()) } answers {
+            exportTranscript(args[1] as ByteBuffer, longText)
+        }
+
+        // When
+        val result = whisperService.transcribe(audioData)
+
+        // Then
+        assertThat(result).isEqualTo(longText)
+        verify(exactly = 2) { whisperService["exportResult"](mockResultPtr, any<ByteBuffer>()) }
+        verify(exactly = 1) { whisperService["freeResult"](mockResultPtr) }
+    }
+
     @Test
     fun `transcribe - no text segments - returns empty string`() = testCoroutineRule.runTest {
         // Given
         whisperService.initializeFromAsset("models/ggml-tiny.bin")
         val audioData = AssetTestHelper.createTestAudioData()
-        every { whisperService["getTextSegmentCount"](mockContextPtr) } returns 0
+        every { whisperService["exportResult"](any<Long>(), any<ByteBuffer>()) } answers {
+            exportTranscript(args[1] as ByteBuffer)
+        }
 
         // When
         val result = whisperService.transcribe(audioData)
@@ -250,6 +692,65 @@ class WhisperServiceTest {
         unmockkObject(com.memexos.app.audio.WaveFileEncoder)
     }
 
+    @Test
+    fun `setSilenceTrimming - initialized - passes settings to setVadEnabled`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        every { whisperService["setVadEnabled"](any<Long>(), any<Boolean>(), any<Int>(), any<Int>()) } just Runs
+
+        // When
+        whisperService.setSilenceTrimming(true, minSilenceMs = 500, padMs = 100)
+        whisperService.setSilenceTrimming(false)
+
+        // Then
+        verifyOrder {
+            whisperService["setVadEnabled"](mockContextPtr, true, 500, 100)
+            whisperService["setVadEnabled"](mockContextPtr, false, 300, 150)
+        }
+    }
+
+    @Test
+    fun `setSilenceTrimming - not initialized - applied once initialized`() = testCoroutineRule.runTest {
+        // Given
+        every { whisperService["setVadEnabled"](any<Long>(), any<Boolean>(), any<Int>(), any<Int>()) } just Runs
+        whisperService.setSilenceTrimming(true, minSilenceMs = 400, padMs = 100)
+        verify(exactly = 0) { whisperService["setVadEnabled"](any<Long>(), any<Boolean>(), any<Int>(), any<Int>()) }
+
+        // When
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+
+        // Then
+        verify(exactly = 1) { whisperService["setVadEnabled"](mockContextPtr, true, 400, 100) }
+    }
+
+    @Test
+    fun `setSilenceTrimming - re-initialized - settings reapplied`() = testCoroutineRule.runTest {
+        // Given
+        every { whisperService["setVadEnabled"](any<Long>(), any<Boolean>(), any<Int>(), any<Int>()) } just Runs
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+        whisperService.setSilenceTrimming(true, minSilenceMs = 500, padMs = 200)
+
+        // When
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+
+        // Then
+        verify(exactly = 2) { whisperService["setVadEnabled"](mockContextPtr, true, 500, 200) }
+    }
+
+    @Test
+    fun `openStream - non-positive step - rejected before reaching native code`() = testCoroutineRule.runTest {
+        // Given
+        whisperService.initializeFromAsset("models/ggml-tiny.bin")
+
+        // When / Then: a zero step would divide by zero natively
+        assertThrows(IllegalArgumentException::class.java) { whisperService.openStream(stepMs = 0) }
+        assertThrows(IllegalArgumentException::class.java) { whisperService.openStream(lengthMs = -1) }
+        assertThrows(IllegalArgumentException::class.java) { whisperService.openStream(keepMs = -200) }
+        verify(exactly = 0) {
+            whisperService["streamOpen"](any<Long>(), any<Int>(), any<Int>(), any<Int>(), any<Int>(), any<Boolean>(), any<Long>())
+        }
+    }
+
     @Test
     fun `release - initialized context - frees native context`() {
         // Given
@@ -311,6 +812,42 @@ class WhisperServiceTest {
         // Then
         assertThat(result1).isEqualTo("Hello world")
         assertThat(result2).isEqualTo("Hello world")
-        verify(exactly = 2) { whisperService["fullTranscribe"](mockContextPtr, 4, any<FloatArray>()) }
+        verify(exactly = 2) { whisperService["fullTranscribe"](mockContextPtr, WhisperService.AUTO_THREADS, DecodeProfile.DEFAULT.id, any<FloatArray>(), mockCancelPtr) }
+        verify(exactly = 2) { whisperService["freeResult"](mockResultPtr) }
+    }
+
+    /**
+     * Write [texts] as segments in the native transcript layout (one second
+     * each, one token of probability 0.5, no-speech probability 0.1). Returns
+     * what the native export returns: the size, or minus the size needed.
+     */
+    private fun exportTranscript(buffer: ByteBuffer, vararg texts: String): Int {
+        val encoded = texts.map { it.toByteArray(Charsets.UTF_8) }
+        val size = 16 + 4 * texts.size + encoded.sumOf { 32 + 8 + (it.size + 3) / 4 * 4 }
+        if (size > buffer.capacity()) {
+            return -size
+        }
+
+        val out = buffer.duplicate().order(ByteOrder.nativeOrder())
+        out.putInt(0, 1)
+        out.putInt(4, texts.size)
+        out.putFloat(8, ln(0.5f))
+        out.putFloat(12, 0.1f)
+        var offset = 16 + 4 * texts.size
+        encoded.forEachIndexed { i, bytes ->
+            out.putInt(16 + 4 * i, offset)
+            out.putLong(offset, i * 1000L)
+            out.putLong(offset + 8, (i + 1) * 1000L)
+            out.putFloat(offset + 16, ln(0.5f))
+            out.putFloat(offset + 20, 0.1f)
+            out.putInt(offset + 24, 1)
+            out.putInt(offset + 28, bytes.size)
+            out.putInt(offset + 32, 100 + i)
+            out.putFloat(offset + 36, 0.5f)
+            out.position(offset + 40)
+            out.put(bytes)
+            offset += 40 + (bytes.size + 3) / 4 * 4
+        }
+        return size
     }
 }